@@ -0,0 +1,186 @@
+#include "admission.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+
+namespace
+{
+    // A shard this large is swept for clients whose buckets have refilled,
+    // which are indistinguishable from clients never seen.
+    const size_t kSweepBuckets = 4096;
+
+    const char *const kClassNames[2] = {"read", "write"};
+
+    void appendCounter(std::string &out, const char *name, const char *cls, const char *reason, uint64_t value)
+    {
+        char line[160];
+        int len = reason ? std::snprintf(line, sizeof(line), "%s{class=\"%s\",reason=\"%s\"} %llu\n", name, cls,
+                                         reason, (unsigned long long)value)
+                         : std::snprintf(line, sizeof(line), "%s{class=\"%s\"} %llu\n", name, cls,
+                                         (unsigned long long)value);
+        if (len > 0)
+            out.append(line, std::min<size_t>(len, sizeof(line) - 1));
+    }
+}
+
+AdmissionControl::AdmissionControl(const AdmissionLimits &limits) : limits_(limits)
+{
+}
+
+bool AdmissionControl::takeToken(const std::string &client, int &retryAfter)
+{
+    const double burst = std::max(1.0, limits_.burst);
+    auto now = std::chrono::steady_clock::now();
+    Shard &shard = shards_[std::hash<std::string>()(client) % kShards];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto it = shard.buckets.find(client);
+    if (it == shard.buckets.end())
+    {
+        if (shard.buckets.size() >= kSweepBuckets)
+        {
+            auto refill = std::chrono::duration<double>(burst / limits_.ratePerSecond);
+            for (auto b = shard.buckets.begin(); b != shard.buckets.end();)
+                b = now - b->second.updated >= refill ? shard.buckets.erase(b) : std::next(b);
+        }
+        it = shard.buckets.emplace(client, Bucket{burst, now}).first;
+    }
+
+    Bucket &bucket = it->second;
+    bucket.tokens = std::min(
+        burst, bucket.tokens + std::chrono::duration<double>(now - bucket.updated).count() * limits_.ratePerSecond);
+    bucket.updated = now;
+    if (bucket.tokens >= 1)
+    {
+        bucket.tokens -= 1;
+        return true;
+    }
+    retryAfter = std::max(1, (int)std::ceil((1 - bucket.tokens) / limits_.ratePerSecond));
+    return false;
+}
+
+Admission AdmissionControl::admit(const std::string &client, RequestClass cls, bool lane, int &retryAfter)
+{
+    int c = (int)cls;
+    if (limits_.ratePerSecond > 0 && !takeToken(client, retryAfter))
+    {
+        rateLimited_[c].fetch_add(1, std::memory_order_relaxed);
+        return Admission::RateLimited;
+    }
+
+    if (lane && !takeLane(c))
+    {
+        overloaded_[c].fetch_add(1, std::memory_order_relaxed);
+        // Lanes drain within a few service times, so a second is plenty.
+        retryAfter = 1;
+        return Admission::Overloaded;
+    }
+    admitted_[c].fetch_add(1, std::memory_order_relaxed);
+    return Admission::Admitted;
+}
+
+bool AdmissionControl::takeLane(int c)
+{
+    std::unique_lock<std::mutex> lock(laneMutex_);
+    // Nobody overtakes a queued request of its own class.
+    if (waiting_[c].empty() && canRun(c))
+    {
+        ++inFlight_[c];
+        return true;
+    }
+    if (limits_.maxWait.count() <= 0 || (int)waiting_[c].size() >= limits_.maxQueued)
+        return false;
+
+    // The waiter lives on this stack; grantWaiters() hands it the slot and
+    // takes it off the queue, or it takes itself off when the wait runs out.
+    Waiter waiter;
+    waiting_[c].push_back(&waiter);
+    queued_[c].fetch_add(1, std::memory_order_relaxed);
+    if (ready_[c].wait_for(lock, limits_.maxWait, [&waiter] { return waiter.granted; }))
+        return true;
+    waiting_[c].erase(std::find(waiting_[c].begin(), waiting_[c].end(), &waiter));
+    return false;
+}
+
+void AdmissionControl::release(RequestClass cls)
+{
+    std::lock_guard<std::mutex> lock(laneMutex_);
+    --inFlight_[(int)cls];
+    grantWaiters();
+}
+
+bool AdmissionControl::canRun(int c) const
+{
+    int limit = c == (int)RequestClass::Read ? limits_.maxReads : limits_.maxWrites;
+    return inFlight_[c] < limit && (limits_.maxInFlight <= 0 || inFlight_[0] + inFlight_[1] < limits_.maxInFlight);
+}
+
+void AdmissionControl::grantWaiters()
+{
+    // Writes first: a freed slot both classes could use goes to a write.
+    for (int c : {(int)RequestClass::Write, (int)RequestClass::Read})
+    {
+        bool granted = false;
+        while (!waiting_[c].empty() && canRun(c))
+        {
+            waiting_[c].front()->granted = true;
+            waiting_[c].pop_front();
+            ++inFlight_[c];
+            granted = true;
+        }
+        if (granted)
+            ready_[c].notify_all();
+    }
+}
+
+std::string AdmissionControl::renderMetrics() const
+{
+    std::string out;
+    out += "# HELP hms_admission_admitted_total Requests let through admission control.\n"
+           "# TYPE hms_admission_admitted_total counter\n";
+    for (int c = 0; c < 2; ++c)
+        appendCounter(out, "hms_admission_admitted_total", kClassNames[c], nullptr,
+                      admitted_[c].load(std::memory_order_relaxed));
+
+    out += "# HELP hms_admission_shed_total Requests turned away: rate_limited (429) or overloaded (503).\n"
+           "# TYPE hms_admission_shed_total counter\n";
+    for (int c = 0; c < 2; ++c)
+    {
+        appendCounter(out, "hms_admission_shed_total", kClassNames[c], "rate_limited",
+                      rateLimited_[c].load(std::memory_order_relaxed));
+        appendCounter(out, "hms_admission_shed_total", kClassNames[c], "overloaded",
+                      overloaded_[c].load(std::memory_order_relaxed));
+    }
+
+    out += "# HELP hms_admission_queued_total Requests that waited in their class's queue for a lane slot.\n"
+           "# TYPE hms_admission_queued_total counter\n";
+    for (int c = 0; c < 2; ++c)
+        appendCounter(out, "hms_admission_queued_total", kClassNames[c], nullptr,
+                      queued_[c].load(std::memory_order_relaxed));
+
+    int inFlight[2], waiting[2];
+    {
+        std::lock_guard<std::mutex> lock(laneMutex_);
+        for (int c = 0; c < 2; ++c)
+        {
+            inFlight[c] = inFlight_[c];
+            waiting[c] = static_cast<int>(waiting_[c].size());
+        }
+    }
+    out += "# HELP hms_admission_in_flight Requests currently holding a lane slot.\n"
+           "# TYPE hms_admission_in_flight gauge\n";
+    for (int c = 0; c < 2; ++c)
+        appendCounter(out, "hms_admission_in_flight", kClassNames[c], nullptr, inFlight[c]);
+    out += "# HELP hms_admission_waiting Requests currently queued for a lane slot.\n"
+           "# TYPE hms_admission_waiting gauge\n";
+    for (int c = 0; c < 2; ++c)
+        appendCounter(out, "hms_admission_waiting", kClassNames[c], nullptr, waiting[c]);
+
+    out += "# HELP hms_admission_lane_limit Most requests each lane admits at once.\n"
+           "# TYPE hms_admission_lane_limit gauge\n";
+    appendCounter(out, "hms_admission_lane_limit", "read", nullptr, limits_.maxReads);
+    appendCounter(out, "hms_admission_lane_limit", "write", nullptr, limits_.maxWrites);
+    return out;
+}
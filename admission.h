@@ -0,0 +1,107 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// Requests are admitted in two independent lanes. Writes block a Crow worker
+// until the writer thread commits them, so without a lane of their own a
+// burst of writes could occupy every worker and stall reads; reads get their
+// own lane so a read storm cannot crowd out data entry either.
+enum class RequestClass
+{
+    Read,
+    Write,
+};
+
+enum class Admission
+{
+    Admitted,
+    RateLimited,  // the client's token bucket is empty: 429
+    Overloaded,   // the request's lane and its queue are full, or it waited too long: 503
+};
+
+struct AdmissionLimits
+{
+    double ratePerSecond = 0;  // per client; 0 turns rate limiting off
+    double burst = 0;          // bucket size, at least one request
+    int maxReads = 1;          // requests in the read lane at once
+    int maxWrites = 1;         // requests in the write lane, including queued writer jobs
+    int maxInFlight = 0;       // both lanes together; 0 for no shared cap
+    int maxQueued = 0;         // requests of each class that may wait for a slot
+    std::chrono::milliseconds maxWait{0};  // longest a queued request waits; 0 turns queueing off
+};
+
+// Admission control in front of every handler: a token bucket per client
+// and a bounded number of requests in each lane. A request that finds its
+// lane full waits in a short bounded queue for its class; when a slot frees
+// up, queued writes are let in before queued reads, so data entry keeps
+// going through a read storm. A request that would wait longer than
+// maxWait, or finds the queue full, gets an immediate 429 or 503 with a
+// Retry-After, so the latency of the requests that are admitted stays close
+// to their service time however far the offered load overshoots.
+class AdmissionControl
+{
+public:
+    explicit AdmissionControl(const AdmissionLimits &limits);
+
+    AdmissionControl(const AdmissionControl &) = delete;
+    AdmissionControl &operator=(const AdmissionControl &) = delete;
+
+    // Charges one token to `client` and, if `lane` is true, takes a slot in
+    // the class's lane, waiting up to maxWait for one; every admitted lane
+    // request must be matched by one release(). When refused, `retryAfter`
+    // is the number of seconds the client should wait.
+    Admission admit(const std::string &client, RequestClass cls, bool lane, int &retryAfter);
+    void release(RequestClass cls);
+
+    // Admission counters, in Prometheus text format, for GET /metrics.
+    std::string renderMetrics() const;
+
+private:
+    struct Bucket
+    {
+        double tokens;
+        std::chrono::steady_clock::time_point updated;
+    };
+
+    // Buckets are sharded by client so concurrent requests from different
+    // clients rarely share a lock.
+    struct Shard
+    {
+        std::mutex mutex;
+        std::unordered_map<std::string, Bucket> buckets;
+    };
+
+    static const int kShards = 16;
+
+    struct Waiter
+    {
+        bool granted = false;
+    };
+
+    bool takeToken(const std::string &client, int &retryAfter);
+    bool takeLane(int c);
+
+    // Both take laneMutex_ as held.
+    bool canRun(int c) const;
+    void grantWaiters();
+
+    const AdmissionLimits limits_;
+    Shard shards_[kShards];
+
+    mutable std::mutex laneMutex_;
+    int inFlight_[2] = {};
+    std::deque<Waiter *> waiting_[2];  // FIFO per class
+    std::condition_variable ready_[2];
+
+    std::atomic<uint64_t> queued_[2] = {};
+    std::atomic<uint64_t> admitted_[2] = {};
+    std::atomic<uint64_t> rateLimited_[2] = {};
+    std::atomic<uint64_t> overloaded_[2] = {};
+};
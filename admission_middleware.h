@@ -0,0 +1,67 @@
+#pragma once
+
+#include "crow.h"
+#include "admission.h"
+
+#include <string>
+
+// Runs every request past AdmissionControl before routing, which may hold
+// the worker for up to the admission wait bound while the request is
+// queued. GET and HEAD are reads, every other method a write. Health checks and scrapes always get
+// through, so an overloaded server still reports itself; /users/changes long
+// polls are rate limited but hold no lane slot while they park.
+struct AdmissionMiddleware
+{
+    AdmissionControl *control = nullptr;  // set before the server starts
+    bool trustForwardedFor = false;       // key clients by X-Forwarded-For
+
+    struct context
+    {
+        bool holdsSlot = false;
+        RequestClass cls = RequestClass::Read;
+    };
+
+    void before_handle(crow::request &req, crow::response &res, context &ctx)
+    {
+        if (!control || req.url == "/health" || req.url == "/metrics")
+            return;
+
+        ctx.cls = req.method == crow::HTTPMethod::Get || req.method == crow::HTTPMethod::Head ? RequestClass::Read
+                                                                                              : RequestClass::Write;
+        bool lane = req.url != "/users/changes";
+        int retryAfter = 1;
+        Admission admission = control->admit(clientKey(req), ctx.cls, lane, retryAfter);
+        if (admission == Admission::Admitted)
+        {
+            ctx.holdsSlot = lane;
+            return;
+        }
+
+        res.code = admission == Admission::RateLimited ? 429 : 503;
+        res.set_header("Retry-After", std::to_string(retryAfter));
+        res.end(admission == Admission::RateLimited ? "Too many requests" : "Server busy, retry later");
+    }
+
+    void after_handle(crow::request &, crow::response &, context &ctx)
+    {
+        if (ctx.holdsSlot)
+            control->release(ctx.cls);
+        ctx.holdsSlot = false;
+    }
+
+    // The peer address, or behind a trusted reverse proxy the address that
+    // proxy appended to X-Forwarded-For; entries further left are whatever
+    // the client chose to send.
+    std::string clientKey(const crow::request &req) const
+    {
+        if (trustForwardedFor)
+        {
+            const std::string &forwarded = req.get_header_value("X-Forwarded-For");
+            size_t comma = forwarded.find_last_of(',');
+            size_t start = forwarded.find_first_not_of(' ', comma == std::string::npos ? 0 : comma + 1);
+            if (start != std::string::npos)
+                return forwarded.substr(start, forwarded.find_last_not_of(' ') + 1 - start);
+        }
+        return req.remote_ip_address;
+    }
+};
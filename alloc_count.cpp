@@ -0,0 +1,97 @@
+#include "alloc_count.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    const unsigned kSlots = 64;
+
+    struct alignas(64) Slot
+    {
+        std::atomic<uint64_t> count{0};
+    };
+
+    Slot slots[kSlots];
+    std::atomic<unsigned> nextSlot{0};
+
+    // Threads take slots round robin the first time they allocate; a plain
+    // thread_local int needs no allocation itself to set up.
+    inline void countAllocation()
+    {
+        thread_local unsigned slot = nextSlot.fetch_add(1, std::memory_order_relaxed) % kSlots;
+        slots[slot].count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void *allocate(std::size_t size)
+    {
+        countAllocation();
+        void *p = std::malloc(size ? size : 1);
+        if (!p)
+            throw std::bad_alloc();
+        return p;
+    }
+}
+
+void *operator new(std::size_t size)
+{
+    return allocate(size);
+}
+
+void *operator new[](std::size_t size)
+{
+    return allocate(size);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+    countAllocation();
+    return std::malloc(size ? size : 1);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept
+{
+    countAllocation();
+    return std::malloc(size ? size : 1);
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void *p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+uint64_t allocationCount()
+{
+    uint64_t total = 0;
+    for (const Slot &slot : slots)
+        total += slot.count.load(std::memory_order_relaxed);
+    return total;
+}
+
+std::string renderAllocationMetrics()
+{
+    char line[256];
+    std::snprintf(line, sizeof(line),
+                  "# HELP hms_allocations_total C++ heap allocations (operator new) since startup.\n"
+                  "# TYPE hms_allocations_total counter\n"
+                  "hms_allocations_total %llu\n",
+                  (unsigned long long)allocationCount());
+    return line;
+}
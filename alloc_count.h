@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Counts C++ heap allocations (operator new) made anywhere in the process,
+// Crow's included. Linking alloc_count.cpp replaces the global operator new
+// and delete; the count lives in cache-line-sized slots that threads are
+// spread over, so counting adds no shared-line contention of its own.
+// SQLite allocates through malloc directly and is not counted.
+uint64_t allocationCount();
+
+// hms_allocations_total, in Prometheus text format, for GET /metrics.
+std::string renderAllocationMetrics();
@@ -0,0 +1,51 @@
+#include "arena.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    // Response scratch bigger than this is not kept between requests, so one
+    // huge reply does not pin its memory on the thread for good.
+    const size_t kMaxKeptBuffer = 1 << 20;
+}
+
+RequestArena &RequestArena::local()
+{
+    thread_local RequestArena arena;
+    return arena;
+}
+
+RequestArena::RequestArena() : resource_(inline_, sizeof(inline_), std::pmr::new_delete_resource())
+{
+}
+
+std::string_view RequestArena::copy(std::string_view text)
+{
+    char *data = allocate(text.size());
+    std::memcpy(data, text.data(), text.size());
+    return std::string_view(data, text.size());
+}
+
+std::string &RequestArena::buffer()
+{
+    if (buffer_.capacity() < bufferHint_)
+        buffer_.reserve(bufferHint_);
+    return buffer_;
+}
+
+std::string RequestArena::takeBuffer()
+{
+    bufferHint_ = std::min(buffer_.size(), kMaxKeptBuffer);
+    std::string body = std::move(buffer_);
+    buffer_ = std::string();
+    return body;
+}
+
+void RequestArena::release()
+{
+    resource_.release();
+    if (buffer_.capacity() > kMaxKeptBuffer)
+        std::string().swap(buffer_);
+    buffer_.clear();
+}
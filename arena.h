@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+
+// Scratch memory for the request a Crow worker thread is handling. Parsed
+// request fields that cannot point into the body (JSON strings with escapes,
+// quoted CSV fields) and the parse tree itself are bump-allocated from it,
+// and everything is dropped at once when the request ends, so a typical
+// POST makes no heap allocations of its own and worker threads do not meet
+// in malloc. The first kInlineBytes live inside the arena itself; larger
+// requests spill into heap blocks that are freed on release().
+class RequestArena
+{
+public:
+    static constexpr size_t kInlineBytes = 16 * 1024;
+
+    // The calling thread's arena. Handlers run start to finish on one
+    // thread, so it needs no locking; see ArenaScope.
+    static RequestArena &local();
+
+    RequestArena();
+
+    RequestArena(const RequestArena &) = delete;
+    RequestArena &operator=(const RequestArena &) = delete;
+
+    std::pmr::memory_resource *resource() { return &resource_; }
+
+    char *allocate(size_t len) { return static_cast<char *>(resource_.allocate(len ? len : 1, 1)); }
+
+    // Copies `text` into the arena.
+    std::string_view copy(std::string_view text);
+
+    // Response body scratch, sized for the last body the thread produced, so
+    // after the first few requests a handler's serialization stops growing
+    // buffers.
+    std::string &buffer();
+
+    // Moves the finished body out, into Crow's response, without copying it;
+    // the next buffer() starts out with room for as much again.
+    std::string takeBuffer();
+
+    // Frees everything allocated since the last release.
+    void release();
+
+private:
+    alignas(std::max_align_t) char inline_[kInlineBytes];
+    std::pmr::monotonic_buffer_resource resource_;
+    std::string buffer_;
+    size_t bufferHint_ = 0;  // capacity to give buffer_ after it was taken
+};
+
+// Releases the thread's arena when a handler returns. Views handed out by
+// the arena, and Patient or Doctor fields parsed into it, must not outlive
+// the scope.
+class ArenaScope
+{
+public:
+    ArenaScope() : arena_(RequestArena::local()) {}
+    ~ArenaScope() { arena_.release(); }
+
+    ArenaScope(const ArenaScope &) = delete;
+    ArenaScope &operator=(const ArenaScope &) = delete;
+
+    RequestArena &arena() { return arena_; }
+
+private:
+    RequestArena &arena_;
+};
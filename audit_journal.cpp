@@ -0,0 +1,313 @@
+#include "audit_journal.h"
+
+#include "json_writer.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+    const char *const kOpNames[] = {"add", "edit", "delete", "assign"};
+
+    size_t roundUpToPowerOfTwo(size_t n)
+    {
+        size_t size = 2;
+        while (size < n)
+            size <<= 1;
+        return size;
+    }
+
+    uint64_t nowMs()
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+                   std::chrono::system_clock::now().time_since_epoch())
+            .count();
+    }
+
+    // Fields of a change, without the closing brace.
+    void appendRecord(std::string &out, uint64_t timestamp, std::string_view who, AuditJournal::Op op,
+                      const Patient &patient, bool withFields)
+    {
+        JsonWriter json(out);
+        json.raw("{\"ts\":", 6);
+        json.integer(static_cast<int64_t>(timestamp));
+        json.raw(",\"who\":", 7);
+        json.string(who);
+        json.raw(",\"op\":\"", 7);
+        const char *name = kOpNames[static_cast<int>(op)];
+        json.raw(name, std::strlen(name));
+        json.raw("\",\"patient\":", 12);
+        json.integer(patient.id);
+        if (!withFields)
+            return;
+        if (op == AuditJournal::Op::Add || op == AuditJournal::Op::Edit)
+        {
+            json.raw(",\"name\":", 8);
+            json.string(patient.name);
+            json.raw(",\"phone\":", 9);
+            json.string(patient.phone);
+            json.raw(",\"disease\":", 11);
+            json.string(patient.disease);
+            json.raw(",\"date\":", 8);
+            json.string(patient.date);
+            if (patient.duration)
+            {
+                json.raw(",\"duration\":", 12);
+                json.integer(patient.duration);
+            }
+        }
+        if (op == AuditJournal::Op::Add || op == AuditJournal::Op::Assign)
+        {
+            json.raw(",\"doctor_id\":", 13);
+            json.integer(patient.doctorId);
+        }
+    }
+}
+
+AuditJournal::AuditJournal(std::string dir, uint64_t segmentBytes, std::chrono::milliseconds flushInterval,
+                           size_t capacity)
+    : dir_(std::move(dir)),
+      segmentBytes_(segmentBytes),
+      flushInterval_(flushInterval),
+      slots_(new Slot[roundUpToPowerOfTwo(capacity)]),
+      mask_(roundUpToPowerOfTwo(capacity) - 1)
+{
+    for (size_t i = 0; i <= mask_; ++i)
+        slots_[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+bool AuditJournal::start()
+{
+    if (::mkdir(dir_.c_str(), 0750) != 0 && errno != EEXIST)
+    {
+        std::cerr << "Cannot create audit directory " << dir_ << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    running_ = true;
+    thread_ = std::thread(&AuditJournal::loop, this);
+    return true;
+}
+
+void AuditJournal::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_.exchange(false))
+            return;
+    }
+    wake_.notify_one();
+    space_.notify_all();
+    thread_.join();
+    if (fd_ >= 0)
+        ::close(fd_);
+    fd_ = -1;
+}
+
+bool AuditJournal::record(std::string_view who, Op op, const Patient &patient)
+{
+    // Serialize before claiming a slot, so a slot is held only for a copy.
+    thread_local std::string line;
+    line.clear();
+    uint64_t timestamp = nowMs();
+    appendRecord(line, timestamp, who, op, patient, true);
+    if (line.size() + 2 > kSlotBytes)
+    {
+        // Oversized field values: keep who, what and when, and say so.
+        line.clear();
+        appendRecord(line, timestamp, who, op, patient, false);
+        line.append(",\"truncated\":true", 17);
+    }
+    line.append("}\n", 2);
+
+    uint64_t pos = head_.load(std::memory_order_relaxed);
+    Slot *slot;
+    for (;;)
+    {
+        slot = &slots_[pos & mask_];
+        uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+        int64_t diff = static_cast<int64_t>(sequence - pos);
+        if (diff == 0)
+        {
+            if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (diff < 0)
+        {
+            // Full: have the writer drain now rather than at its next flush,
+            // and wait until this slot is free again.
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (!running_.load())
+            {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            waits_.fetch_add(1, std::memory_order_relaxed);
+            wakeRequested_ = true;
+            wake_.notify_one();
+            space_.wait(lock, [&] {
+                return !running_.load() ||
+                       static_cast<int64_t>(slot->sequence.load(std::memory_order_acquire) - pos) >= 0;
+            });
+            pos = head_.load(std::memory_order_relaxed);
+        }
+        else
+            pos = head_.load(std::memory_order_relaxed);
+    }
+    slot->timestamp = timestamp;
+    slot->length = static_cast<uint32_t>(line.size());
+    std::memcpy(slot->data, line.data(), line.size());
+    slot->sequence.store(pos + 1, std::memory_order_release);
+    recorded_.fetch_add(1, std::memory_order_relaxed);
+
+    // Once per half ring, have the writer drain now instead of at its next
+    // flush, so a burst does not run into a full ring.
+    if (((pos + 1) & (mask_ >> 1)) == 0)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            wakeRequested_ = true;
+        }
+        wake_.notify_one();
+    }
+    return true;
+}
+
+size_t AuditJournal::drain(std::string &batch, uint64_t &firstTimestamp)
+{
+    size_t taken = 0;
+    for (;;)
+    {
+        Slot &slot = slots_[tail_ & mask_];
+        if (slot.sequence.load(std::memory_order_acquire) != tail_ + 1)
+            return taken;
+        if (!taken)
+            firstTimestamp = slot.timestamp;
+        batch.append(slot.data, slot.length);
+        slot.sequence.store(tail_ + mask_ + 1, std::memory_order_release);
+        ++tail_;
+        ++taken;
+    }
+}
+
+void AuditJournal::loop()
+{
+    std::string batch;
+    for (;;)
+    {
+        // Read the flag first, so the final drain after stop() sees every
+        // record queued before it.
+        bool running = running_.load();
+        batch.clear();
+        uint64_t firstTimestamp = 0;
+        size_t taken = drain(batch, firstTimestamp);
+        if (taken)
+        {
+            // Slots are free again; let waiting producers refill them while
+            // this batch is written.
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+            }
+            space_.notify_all();
+            if (writeBatch(batch, firstTimestamp))
+                written_.fetch_add(taken, std::memory_order_relaxed);
+            else
+                errors_.fetch_add(taken, std::memory_order_relaxed);
+        }
+        if (!running)
+            return;
+        std::unique_lock<std::mutex> lock(mutex_);
+        wake_.wait_for(lock, flushInterval_, [this] { return wakeRequested_ || !running_.load(); });
+        wakeRequested_ = false;
+    }
+}
+
+bool AuditJournal::openSegment(uint64_t firstTimestamp)
+{
+    if (fd_ >= 0)
+        ::close(fd_);
+    char name[64];
+    std::snprintf(name, sizeof(name), "/audit-%013llu.log", static_cast<unsigned long long>(firstTimestamp));
+    std::string path = dir_ + name;
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0640);
+    if (fd_ < 0)
+    {
+        std::cerr << "Cannot open audit segment " << path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    struct stat st;
+    segmentSize_ = ::fstat(fd_, &st) == 0 ? st.st_size : 0;
+
+    // Make the new file's directory entry durable too.
+    int dirFd = ::open(dir_.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dirFd >= 0)
+    {
+        ::fsync(dirFd);
+        ::close(dirFd);
+    }
+    segments_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool AuditJournal::writeBatch(const std::string &batch, uint64_t firstTimestamp)
+{
+    if ((fd_ < 0 || segmentSize_ >= segmentBytes_) && !openSegment(firstTimestamp))
+        return false;
+    for (size_t done = 0; done < batch.size();)
+    {
+        ssize_t n = ::write(fd_, batch.data() + done, batch.size() - done);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+        {
+            std::cerr << "Audit journal write failed: " << std::strerror(errno) << std::endl;
+            // Start a fresh segment next time rather than appending after a
+            // partial line.
+            segmentSize_ = segmentBytes_;
+            return false;
+        }
+        done += n;
+        segmentSize_ += n;
+    }
+    bytes_.fetch_add(batch.size(), std::memory_order_relaxed);
+    if (::fdatasync(fd_) != 0)
+    {
+        std::cerr << "Audit journal fdatasync failed: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    syncs_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+std::string AuditJournal::renderMetrics() const
+{
+    struct
+    {
+        const char *name;
+        const char *help;
+        const std::atomic<uint64_t> &value;
+    } counters[] = {
+        {"hms_audit_records_total", "Changes queued for the audit journal.", recorded_},
+        {"hms_audit_dropped_total", "Changes dropped because the audit journal was not running.", dropped_},
+        {"hms_audit_waits_total", "Times a change waited for space in a full audit ring.", waits_},
+        {"hms_audit_written_total", "Changes written and synced to the audit journal.", written_},
+        {"hms_audit_write_errors_total", "Changes lost to audit journal write or sync errors.", errors_},
+        {"hms_audit_bytes_total", "Bytes appended to audit segments.", bytes_},
+        {"hms_audit_syncs_total", "fdatasync calls on audit segments, one per batch.", syncs_},
+        {"hms_audit_segments_total", "Audit segments opened.", segments_},
+    };
+    std::string out;
+    char line[256];
+    for (const auto &counter : counters)
+    {
+        std::snprintf(line, sizeof(line), "# HELP %s %s\n# TYPE %s counter\n%s %llu\n", counter.name, counter.help,
+                      counter.name, counter.name,
+                      static_cast<unsigned long long>(counter.value.load(std::memory_order_relaxed)));
+        out += line;
+    }
+    return out;
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "patients.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+// Who changed which patient, and when: an append-only journal of every
+// committed users mutation.
+//
+// Handlers do not wait for the disk. record() serializes the change into a
+// slot of a bounded lock-free ring (Vyukov's MPSC queue: a producer claims a
+// slot with one compare-and-swap and publishes it with a release store), and
+// a background thread drains the ring every flush interval, appends the batch
+// to the current segment with one write and makes it durable with one
+// fdatasync. The ring holds more than the largest burst the server makes, a
+// /users/bulk chunk, and each time producers have filled half of it they
+// wake the writer thread early, so record() does not wait in practice. No
+// change is ever dropped while the journal runs: should the ring fill all
+// the same, record() waits for the writer to free slots (counted in
+// hms_audit_waits_total).
+//
+// Segments are files of JSON lines named audit-<ms of first record>.log,
+// so their names sort by time; one is closed and the next started after the
+// batch that takes it past the segment size. Each line is
+//
+//   {"ts":<ms since the epoch, UTC>,"who":"<user>","op":"add|edit|delete|assign",
+//    "patient":<id>, ...the fields the change set}
+//
+// bench/hms_audit.cpp reads them back by patient and time range.
+class AuditJournal
+{
+public:
+    enum class Op
+    {
+        Add,
+        Edit,
+        Delete,
+        Assign,
+    };
+
+    static constexpr size_t kSlotBytes = 2048 - 24;  // a slot is 2 KiB in all
+    static constexpr size_t kDefaultCapacity = 16384;  // slots; 32 MiB
+
+    AuditJournal(std::string dir, uint64_t segmentBytes, std::chrono::milliseconds flushInterval,
+                 size_t capacity = kDefaultCapacity);
+    ~AuditJournal() { stop(); }
+
+    AuditJournal(const AuditJournal &) = delete;
+    AuditJournal &operator=(const AuditJournal &) = delete;
+
+    // Creates the directory and starts the writer thread.
+    bool start();
+
+    // Writes out everything queued, then stops the thread.
+    void stop();
+
+    // Queues `patient` as changed by `who`. Add and edit record the patient's
+    // fields, assign its doctor_id, delete only the id. Waits for space if
+    // the ring is full; returns false, dropping the change, only when the
+    // journal is not running.
+    bool record(std::string_view who, Op op, const Patient &patient);
+
+    // Counters in Prometheus text format, for GET /metrics.
+    std::string renderMetrics() const;
+
+private:
+    struct Slot
+    {
+        std::atomic<uint64_t> sequence;
+        uint64_t timestamp;
+        uint32_t length;
+        char data[kSlotBytes];
+    };
+
+    void loop();
+    // Moves whatever is queued into `batch`; returns the records taken.
+    size_t drain(std::string &batch, uint64_t &firstTimestamp);
+    bool writeBatch(const std::string &batch, uint64_t firstTimestamp);
+    bool openSegment(uint64_t firstTimestamp);
+
+    const std::string dir_;
+    const uint64_t segmentBytes_;
+    const std::chrono::milliseconds flushInterval_;
+
+    std::unique_ptr<Slot[]> slots_;
+    const size_t mask_;
+    alignas(64) std::atomic<uint64_t> head_{0};  // next slot a producer claims
+    alignas(64) uint64_t tail_ = 0;              // next slot the writer reads
+
+    // Producers waiting for space, and the writer waiting for its next
+    // flush, block here; the fast path never touches them.
+    std::mutex mutex_;
+    std::condition_variable space_;
+    std::condition_variable wake_;
+    bool wakeRequested_ = false;
+
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    int fd_ = -1;
+    uint64_t segmentSize_ = 0;
+
+    std::atomic<uint64_t> recorded_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<uint64_t> waits_{0};
+    std::atomic<uint64_t> written_{0};
+    std::atomic<uint64_t> bytes_{0};
+    std::atomic<uint64_t> syncs_{0};
+    std::atomic<uint64_t> segments_{0};
+    std::atomic<uint64_t> errors_{0};
+};
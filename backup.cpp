@@ -0,0 +1,151 @@
+#include "backup.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    const int kMinPagesPerStep = 1;
+    const int kMaxPagesPerStep = 16384;
+}
+
+OnlineBackup::OnlineBackup(std::string path, std::chrono::milliseconds stepBudget)
+    : path_(std::move(path)), partialPath_(path_ + ".partial"), stepBudget_(stepBudget),
+      started_(std::chrono::steady_clock::now())
+{
+    progress_.state = "running";
+    progress_.path = path_;
+    progress_.pagesPerStep = pagesPerStep_;
+}
+
+OnlineBackup::~OnlineBackup()
+{
+    cancel();
+}
+
+void OnlineBackup::cancel()
+{
+    if (backup_)
+        sqlite3_backup_finish(backup_);
+    backup_ = nullptr;
+    if (dest_)
+    {
+        sqlite3_close(dest_);
+        dest_ = nullptr;
+        std::remove(partialPath_.c_str());
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (progress_.state == "running")
+        {
+            progress_.state = "failed";
+            progress_.error = "cancelled";
+        }
+    }
+}
+
+bool OnlineBackup::open(std::string &error)
+{
+    std::error_code ec;
+    fs::path dir = fs::path(path_).parent_path();
+    if (!dir.empty())
+        fs::create_directories(dir, ec);
+    if (fs::exists(path_, ec))
+    {
+        error = "backup file already exists";
+        return false;
+    }
+    fs::remove(partialPath_, ec);
+
+    if (sqlite3_open_v2(partialPath_.c_str(), &dest_, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX,
+                        nullptr) != SQLITE_OK)
+    {
+        error = dest_ ? sqlite3_errmsg(dest_) : "cannot open backup file";
+        sqlite3_close(dest_);
+        dest_ = nullptr;
+        return false;
+    }
+    return true;
+}
+
+bool OnlineBackup::step(DbConnection &source)
+{
+    if (!dest_)
+        return false;
+    if (!backup_)
+    {
+        backup_ = sqlite3_backup_init(dest_, "main", source.handle(), "main");
+        if (!backup_)
+        {
+            fail(sqlite3_errmsg(dest_));
+            return false;
+        }
+    }
+
+    auto stepStarted = std::chrono::steady_clock::now();
+    int rc = sqlite3_backup_step(backup_, pagesPerStep_);
+    auto took = std::chrono::steady_clock::now() - stepStarted;
+    if (took > stepBudget_)
+        pagesPerStep_ = std::max(kMinPagesPerStep, pagesPerStep_ / 2);
+    else if (took < stepBudget_ / 2)
+        pagesPerStep_ = std::min(kMaxPagesPerStep, pagesPerStep_ * 2);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        progress_.pagesTotal = sqlite3_backup_pagecount(backup_);
+        progress_.pagesRemaining = sqlite3_backup_remaining(backup_);
+        progress_.pagesPerStep = pagesPerStep_;
+        progress_.elapsedMs =
+            std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started_).count();
+    }
+
+    if (rc == SQLITE_OK || rc == SQLITE_BUSY || rc == SQLITE_LOCKED)
+        return true;
+    if (rc != SQLITE_DONE)
+    {
+        fail(sqlite3_errstr(rc));
+        return false;
+    }
+
+    rc = sqlite3_backup_finish(backup_);
+    backup_ = nullptr;
+    int closeRc = sqlite3_close(dest_);
+    dest_ = nullptr;
+    std::error_code ec;
+    if (rc != SQLITE_OK || closeRc != SQLITE_OK)
+        ec = std::make_error_code(std::errc::io_error);
+    else
+        fs::rename(partialPath_, path_, ec);
+    if (ec)
+    {
+        fs::remove(partialPath_, ec);
+        fail(rc != SQLITE_OK ? sqlite3_errstr(rc) : "cannot finish backup file");
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    progress_.state = "done";
+    std::cout << "Backup written to " << path_ << " (" << progress_.pagesTotal << " pages, " << progress_.elapsedMs
+              << " ms)" << std::endl;
+    return false;
+}
+
+void OnlineBackup::fail(const std::string &error)
+{
+    std::cerr << "Backup to " << path_ << " failed: " << error << std::endl;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        progress_.state = "failed";
+        progress_.error = error;
+    }
+    cancel();
+}
+
+BackupProgress OnlineBackup::progress() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return progress_;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "db.h"
+
+#include <chrono>
+#include <mutex>
+#include <string>
+
+// Snapshot of a backup's progress, safe to read from any thread.
+struct BackupProgress
+{
+    std::string state = "idle";  // idle, running, done or failed
+    std::string path;
+    int pagesTotal = 0;
+    int pagesRemaining = 0;
+    int pagesPerStep = 0;
+    long long elapsedMs = 0;
+    std::string error;
+};
+
+// One online backup, copied with sqlite3_backup_step a bounded number of
+// pages at a time. It is driven by the writer thread between write batches,
+// with the writer's own connection as the source: SQLite applies writes made
+// through the source connection to the copy as it goes instead of restarting
+// it, so the finished file is a consistent snapshot of the database as of
+// the last step. Readers on other connections are never blocked.
+//
+// Each step is sized to take no longer than `stepBudget`: the page count
+// doubles while steps finish in under half the budget and halves when one
+// overruns. That bounds how long a queued write can wait behind the backup.
+// The copy is written to `<path>.partial` and renamed into place when done.
+class OnlineBackup
+{
+public:
+    OnlineBackup(std::string path, std::chrono::milliseconds stepBudget);
+    ~OnlineBackup();
+
+    OnlineBackup(const OnlineBackup &) = delete;
+    OnlineBackup &operator=(const OnlineBackup &) = delete;
+
+    // Creates the destination file. Call once, on any thread, before step().
+    bool open(std::string &error);
+
+    // Copies the next chunk from `source`; writer thread only. Returns false
+    // once the backup has finished or failed.
+    bool step(DbConnection &source);
+
+    // Abandons an unfinished backup and removes the partial file; writer
+    // thread only, before the source connection is closed.
+    void cancel();
+
+    // Pause between steps, so readers get the disk between chunks.
+    std::chrono::milliseconds pause() const { return stepBudget_; }
+
+    BackupProgress progress() const;
+
+private:
+    void fail(const std::string &error);
+
+    const std::string path_;
+    const std::string partialPath_;
+    const std::chrono::milliseconds stepBudget_;
+    const std::chrono::steady_clock::time_point started_;
+    sqlite3 *dest_ = nullptr;
+    sqlite3_backup *backup_ = nullptr;
+    int pagesPerStep_ = 64;
+
+    mutable std::mutex mutex_;
+    BackupProgress progress_;
+};
@@ -0,0 +1,148 @@
+// Reads the audit journal back: prints the records of one patient, of a
+// time range, or both, oldest first, as the JSON lines they were written as.
+//
+//   hms_audit [--dir audit] [--patient ID] [--from DATE] [--to DATE]
+//
+// DATE is anything the server accepts as an appointment date (2025-03-07,
+// 7.3.2025 09:30, ...), taken as UTC; --to without a time includes that
+// whole day. Segments are named after their first record's time, so those
+// ending before --from or starting after --to are not opened. A line left
+// half-written by a crash is skipped.
+#include "arena.h"
+#include "dates.h"
+#include "json_view.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    struct Segment
+    {
+        uint64_t start;  // ms of its first record
+        std::string path;
+    };
+
+    // Milliseconds since the epoch for a date; `endOfDay` moves a date
+    // without a time to the start of the next day.
+    bool parseDate(const char *text, bool endOfDay, uint64_t &ms)
+    {
+        std::string iso;
+        if (!normalizeDate(text, iso))
+            return false;
+        bool timed = iso.size() > 10;
+        if (!timed)
+            iso += "T00:00";
+        int64_t minutes;
+        if (!isoMinutes(iso, minutes) || minutes < 0)
+            return false;
+        if (endOfDay && !timed)
+            minutes += 1440;
+        ms = static_cast<uint64_t>(minutes) * 60000;
+        return true;
+    }
+
+    bool listSegments(const std::string &dir, std::vector<Segment> &segments)
+    {
+        DIR *handle = opendir(dir.c_str());
+        if (!handle)
+        {
+            std::fprintf(stderr, "Cannot open %s: %s\n", dir.c_str(), std::strerror(errno));
+            return false;
+        }
+        while (dirent *entry = readdir(handle))
+        {
+            unsigned long long start;
+            int end = 0;
+            if (std::sscanf(entry->d_name, "audit-%13llu.log%n", &start, &end) == 1 && entry->d_name[end] == '\0' &&
+                end > 0)
+                segments.push_back(Segment{start, dir + "/" + entry->d_name});
+        }
+        closedir(handle);
+        std::sort(segments.begin(), segments.end(),
+                  [](const Segment &a, const Segment &b) { return a.start < b.start; });
+        return true;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::string dir = "audit";
+    long long patient = 0;
+    uint64_t from = 0, to = UINT64_MAX;
+    for (int i = 1; i < argc; i += 2)
+    {
+        std::string arg = argv[i];
+        bool ok = i + 1 < argc;
+        if (!ok)
+            ;
+        else if (arg == "--dir")
+            dir = argv[i + 1];
+        else if (arg == "--patient")
+            ok = (patient = std::atoll(argv[i + 1])) > 0;
+        else if (arg == "--from")
+            ok = parseDate(argv[i + 1], false, from);
+        else if (arg == "--to")
+            ok = parseDate(argv[i + 1], true, to);
+        else
+            ok = false;
+        if (!ok)
+        {
+            std::fprintf(stderr, "usage: %s [--dir audit] [--patient ID] [--from DATE] [--to DATE]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    std::vector<Segment> segments;
+    if (!listSegments(dir, segments))
+        return 1;
+
+    size_t matched = 0, skipped = 0, opened = 0;
+    std::string line;
+    for (size_t i = 0; i < segments.size(); ++i)
+    {
+        if (segments[i].start >= to)
+            break;
+        if (i + 1 < segments.size() && segments[i + 1].start <= from)
+            continue;
+        std::ifstream in(segments[i].path, std::ios::binary);
+        if (!in)
+        {
+            std::fprintf(stderr, "Cannot read %s\n", segments[i].path.c_str());
+            return 1;
+        }
+        ++opened;
+        while (std::getline(in, line))
+        {
+            ArenaScope scope;
+            JsonView json(scope.arena());
+            JsonView::Value record = json.parse(line) ? json.root() : JsonView::Value();
+            if (record.t() != JsonView::Type::Object || record["ts"].t() != JsonView::Type::Number)
+            {
+                ++skipped;
+                continue;
+            }
+            int64_t ts = record["ts"].i();
+            if (ts < 0 || static_cast<uint64_t>(ts) < from || static_cast<uint64_t>(ts) >= to)
+                continue;
+            if (patient && record["patient"].i() != patient)
+                continue;
+            std::fwrite(line.data(), 1, line.size(), stdout);
+            std::fputc('\n', stdout);
+            ++matched;
+        }
+    }
+    std::fprintf(stderr, "%zu records from %zu of %zu segments", matched, opened, segments.size());
+    if (skipped)
+        std::fprintf(stderr, ", %zu unreadable lines skipped", skipped);
+    std::fputc('\n', stderr);
+    return 0;
+}
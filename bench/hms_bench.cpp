@@ -0,0 +1,613 @@
+// HTTP load generator for a running crow_sqlite_crud server.
+//
+// Each worker thread logs in, keeps one keep-alive connection to the server
+// and issues a weighted mix of /users, /add, /edit, /delete and /auth calls.
+//
+// Closed loop (the default): every worker sends its next request as soon as
+// the previous response arrives. Latency is corrected for coordinated
+// omission after the run, HdrHistogram-style: every sample slower than the
+// mean service time also stands in for the requests that would have been
+// issued while it was outstanding.
+//
+// Open loop (--rate N): requests are scheduled at a fixed total rate spread
+// across the workers, and latency is measured from each request's scheduled
+// send time, so a stalled server is charged for the queue it builds up.
+//
+// Requests turned away by the server's admission control (429 or 503) are
+// reported in the shed column rather than as errors; their latency still
+// counts, since a fast refusal is what keeps the tail bounded.
+//
+// The last line, "summary key=value ...", repeats the total row for scripts
+// such as bench/scaling_suite.sh.
+//
+// The server's hms_allocations_total is read from /metrics at the start and
+// end of the measured window and reported as heap allocations per request
+// (scrapes and warmup stragglers included, so it is a close upper bound).
+//
+//   hms_bench [--host 127.0.0.1] [--port 3000] [--threads 8] [--duration 10]
+//             [--warmup 2] [--rate 0] [--mix users=70,add=10,edit=10,delete=5,auth=5]
+//             [--users-path /users] [--username admin] [--password 1234]
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+namespace
+{
+    enum Op
+    {
+        OpUsers,
+        OpAdd,
+        OpEdit,
+        OpDelete,
+        OpAuth,
+        OpCount
+    };
+
+    const char *const kOpNames[OpCount] = {"users", "add", "edit", "delete", "auth"};
+
+    struct Options
+    {
+        std::string host = "127.0.0.1";
+        int port = 3000;
+        int threads = 8;
+        double duration = 10;
+        double warmup = 2;
+        double rate = 0;  // total requests per second; 0 means closed loop
+        int weights[OpCount] = {70, 10, 10, 5, 5};
+        std::string usersPath = "/users";
+        std::string username = "admin";
+        std::string password = "1234";
+    };
+
+    // Log-linear latency histogram: 16 sub-buckets per power of two, so any
+    // recorded value is within about 6% of the true one.
+    class Histogram
+    {
+    public:
+        static const int kSubBits = 4;
+
+        void record(uint64_t ns, uint64_t count = 1)
+        {
+            counts_[index(ns)] += count;
+            total_ += count;
+            max_ = std::max(max_, ns);
+            sum_ += ns * count;
+        }
+
+        void merge(const Histogram &other)
+        {
+            for (size_t i = 0; i < counts_.size(); ++i)
+                counts_[i] += other.counts_[i];
+            total_ += other.total_;
+            max_ = std::max(max_, other.max_);
+            sum_ += other.sum_;
+        }
+
+        // Copy in which every sample above `interval` is backfilled with the
+        // samples that requests issued every `interval` behind it would have
+        // seen (HdrHistogram's copyCorrectedForCoordinatedOmission).
+        Histogram corrected(uint64_t interval) const
+        {
+            Histogram out;
+            for (size_t i = 0; i < counts_.size(); ++i)
+            {
+                if (!counts_[i])
+                    continue;
+                uint64_t value = valueAt(i);
+                out.record(value, counts_[i]);
+                if (!interval)
+                    continue;
+                for (uint64_t missing = value > interval ? value - interval : 0; missing >= interval;
+                     missing -= interval)
+                    out.record(missing, counts_[i]);
+            }
+            out.max_ = std::max(out.max_, max_);
+            return out;
+        }
+
+        uint64_t percentile(double p) const
+        {
+            if (!total_)
+                return 0;
+            uint64_t rank = (uint64_t)std::ceil(p / 100.0 * total_);
+            uint64_t seen = 0;
+            for (size_t i = 0; i < counts_.size(); ++i)
+            {
+                seen += counts_[i];
+                if (seen >= rank)
+                    return std::min(valueAt(i), max_);
+            }
+            return max_;
+        }
+
+        uint64_t total() const { return total_; }
+        uint64_t max() const { return max_; }
+        uint64_t mean() const { return total_ ? sum_ / total_ : 0; }
+
+    private:
+        static size_t index(uint64_t v)
+        {
+            if (v < (1u << kSubBits))
+                return v;
+            int msb = 63 - __builtin_clzll(v);
+            uint64_t sub = (v >> (msb - kSubBits)) & ((1u << kSubBits) - 1);
+            return ((size_t)(msb - kSubBits + 1) << kSubBits) + sub;
+        }
+
+        // Upper edge of bucket `i`.
+        static uint64_t valueAt(size_t i)
+        {
+            if (i < (1u << kSubBits))
+                return i;
+            int shift = (int)(i >> kSubBits) - 1;
+            uint64_t sub = i & ((1u << kSubBits) - 1);
+            return (((1ull << kSubBits) + sub + 1) << shift) - 1;
+        }
+
+        std::vector<uint64_t> counts_ = std::vector<uint64_t>(64 << kSubBits);
+        uint64_t total_ = 0;
+        uint64_t max_ = 0;
+        uint64_t sum_ = 0;
+    };
+
+    // One keep-alive HTTP/1.1 connection. Reconnects after any error.
+    class Connection
+    {
+    public:
+        Connection(const Options &options) : options_(options) {}
+        ~Connection() { close(); }
+
+        // Sends one request and reads the response; returns the status code,
+        // or 0 on a transport error.
+        int request(const char *method, const std::string &path, const std::string &body, const std::string &cookie,
+                    std::string *setCookie = nullptr, std::string *responseBody = nullptr)
+        {
+            for (int attempt = 0; attempt < 2; ++attempt)
+            {
+                if (fd_ < 0 && !connect())
+                    return 0;
+                out_.clear();
+                out_ += method;
+                out_ += ' ';
+                out_ += path;
+                out_ += " HTTP/1.1\r\nHost: ";
+                out_ += options_.host;
+                out_ += "\r\n";
+                if (!cookie.empty())
+                {
+                    out_ += "Cookie: ";
+                    out_ += cookie;
+                    out_ += "\r\n";
+                }
+                if (!body.empty() || std::strcmp(method, "POST") == 0)
+                {
+                    out_ += "Content-Type: application/json\r\nContent-Length: ";
+                    out_ += std::to_string(body.size());
+                    out_ += "\r\n";
+                }
+                out_ += "\r\n";
+                out_ += body;
+
+                int status = sendAndRead(setCookie, responseBody);
+                if (status)
+                    return status;
+                close();
+            }
+            return 0;
+        }
+
+    private:
+        bool connect()
+        {
+            fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+            if (fd_ < 0)
+                return false;
+            int one = 1;
+            setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(options_.port);
+            if (inet_pton(AF_INET, options_.host.c_str(), &addr.sin_addr) != 1 ||
+                ::connect(fd_, (sockaddr *)&addr, sizeof(addr)) != 0)
+            {
+                close();
+                return false;
+            }
+            in_.clear();
+            return true;
+        }
+
+        void close()
+        {
+            if (fd_ >= 0)
+                ::close(fd_);
+            fd_ = -1;
+        }
+
+        bool fill()
+        {
+            char buf[64 * 1024];
+            ssize_t n = ::recv(fd_, buf, sizeof(buf), 0);
+            if (n <= 0)
+                return false;
+            in_.append(buf, n);
+            return true;
+        }
+
+        static bool headerIs(const std::string &line, const char *name)
+        {
+            size_t len = std::strlen(name);
+            return line.size() > len && strncasecmp(line.c_str(), name, len) == 0 && line[len] == ':';
+        }
+
+        int sendAndRead(std::string *setCookie, std::string *responseBody)
+        {
+            for (size_t sent = 0; sent < out_.size();)
+            {
+                ssize_t n = ::send(fd_, out_.data() + sent, out_.size() - sent, MSG_NOSIGNAL);
+                if (n <= 0)
+                    return 0;
+                sent += n;
+            }
+
+            size_t headerEnd;
+            while ((headerEnd = in_.find("\r\n\r\n")) == std::string::npos)
+                if (!fill())
+                    return 0;
+
+            int status = 0;
+            size_t contentLength = 0;
+            bool closeAfter = false;
+            size_t pos = 0;
+            while (pos < headerEnd)
+            {
+                size_t eol = in_.find("\r\n", pos);
+                std::string line = in_.substr(pos, eol - pos);
+                pos = eol + 2;
+                if (!status)
+                    status = line.size() > 12 ? std::atoi(line.c_str() + 9) : 0;
+                else if (headerIs(line, "Content-Length"))
+                    contentLength = std::strtoull(line.c_str() + 15, nullptr, 10);
+                else if (headerIs(line, "Connection"))
+                    closeAfter = line.find("close") != std::string::npos;
+                else if (setCookie && headerIs(line, "Set-Cookie"))
+                    *setCookie = line.substr(line.find_first_not_of(' ', 11));
+            }
+
+            size_t total = headerEnd + 4 + contentLength;
+            while (in_.size() < total)
+                if (!fill())
+                    return 0;
+            if (responseBody)
+                responseBody->assign(in_, headerEnd + 4, contentLength);
+            in_.erase(0, total);
+            if (closeAfter)
+                close();
+            return status;
+        }
+
+        const Options &options_;
+        int fd_ = -1;
+        std::string out_;
+        std::string in_;
+    };
+
+    struct WorkerStats
+    {
+        Histogram latency[OpCount];
+        uint64_t errors[OpCount] = {};
+        uint64_t shed[OpCount] = {};  // 429 and 503 from admission control
+    };
+
+    // hms_allocations_total from a /metrics scrape, or -1 if it is missing.
+    int64_t scrapeAllocations(Connection &conn)
+    {
+        std::string body;
+        if (conn.request("GET", "/metrics", "", "", nullptr, &body) != 200)
+            return -1;
+        static const char kSample[] = "\nhms_allocations_total ";
+        size_t pos = body.find(kSample);
+        return pos == std::string::npos ? -1 : std::strtoll(body.c_str() + pos + sizeof(kSample) - 1, nullptr, 10);
+    }
+
+    // Pulls every "id": value out of a /users JSON body.
+    std::vector<int64_t> parseIds(const std::string &body)
+    {
+        std::vector<int64_t> ids;
+        for (size_t pos = 0; (pos = body.find("\"id\":", pos)) != std::string::npos;)
+        {
+            pos += 5;
+            ids.push_back(std::strtoll(body.c_str() + pos, nullptr, 10));
+        }
+        return ids;
+    }
+
+    std::string cookieValue(const std::string &setCookie)
+    {
+        return setCookie.substr(0, setCookie.find(';'));
+    }
+
+    void worker(const Options &options, int index, Clock::time_point start, Clock::time_point measureFrom,
+                Clock::time_point end, std::vector<int64_t> ids, WorkerStats &stats)
+    {
+        Connection conn(options);
+        std::mt19937_64 rng(0x9e3779b97f4a7c15ull * (index + 1));
+        std::discrete_distribution<int> pick(options.weights, options.weights + OpCount);
+        std::string authBody = "{\"username\":\"" + options.username + "\",\"password\":\"" + options.password + "\"}";
+
+        std::string setCookie;
+        if (conn.request("POST", "/auth", authBody, "", &setCookie) != 200 || setCookie.empty())
+        {
+            std::fprintf(stderr, "worker %d: login failed\n", index);
+            return;
+        }
+        std::string cookie = cookieValue(setCookie);
+
+        // Open loop: this worker's share of the total rate, offset so the
+        // workers do not all fire at once.
+        std::chrono::nanoseconds interval(0);
+        Clock::time_point next = start;
+        if (options.rate > 0)
+        {
+            interval = std::chrono::nanoseconds((int64_t)(1e9 * options.threads / options.rate));
+            next += interval * index / options.threads;
+        }
+
+        std::string body;
+        uint64_t seq = 0;
+        for (;;)
+        {
+            Clock::time_point intended = Clock::now();
+            if (interval.count())
+            {
+                intended = next;
+                next += interval;
+                if (intended > Clock::now())
+                    std::this_thread::sleep_until(intended);
+            }
+            if (intended >= end)
+                break;
+
+            int op = pick(rng);
+            char buf[256];
+            int status;
+            switch (op)
+            {
+            case OpUsers:
+                status = conn.request("GET", options.usersPath, "", cookie);
+                break;
+            case OpAdd:
+                std::snprintf(buf, sizeof(buf),
+                              "{\"name\":\"Bench %d-%llu\",\"phone\":\"+92-300-%07llu\",\"disease\":\"Influenza\","
+                              "\"date\":\"2025-%02d-%02d\"}",
+                              index, (unsigned long long)seq, (unsigned long long)(seq % 10000000),
+                              (int)(1 + seq % 12), (int)(1 + seq % 28));
+                status = conn.request("POST", "/add", buf, cookie);
+                break;
+            case OpEdit:
+                std::snprintf(buf, sizeof(buf),
+                              "{\"id\":%lld,\"name\":\"Edited %d-%llu\",\"phone\":\"+92-301-0000000\","
+                              "\"disease\":\"Asthma\",\"date\":\"2025-06-15\"}",
+                              ids.empty() ? 0LL : (long long)ids[rng() % ids.size()], index, (unsigned long long)seq);
+                status = conn.request("POST", "/edit", buf, cookie);
+                break;
+            case OpDelete:
+            {
+                // Deletes consume this worker's ids; once they run out the
+                // request still goes through the writer but matches nothing.
+                long long id = 0;
+                if (!ids.empty())
+                {
+                    size_t at = rng() % ids.size();
+                    id = ids[at];
+                    ids[at] = ids.back();
+                    ids.pop_back();
+                }
+                std::snprintf(buf, sizeof(buf), "{\"id\":%lld}", id);
+                status = conn.request("POST", "/delete", buf, cookie);
+                break;
+            }
+            default:
+                status = conn.request("POST", "/auth", authBody, "");
+                break;
+            }
+            ++seq;
+
+            Clock::time_point done = Clock::now();
+            if (intended < measureFrom)
+                continue;
+            stats.latency[op].record(std::chrono::duration_cast<std::chrono::nanoseconds>(done - intended).count());
+            if (status == 429 || status == 503)
+                ++stats.shed[op];
+            else if (status < 200 || status >= 300)
+                ++stats.errors[op];
+        }
+    }
+
+    bool parseMix(const char *text, int *weights)
+    {
+        std::fill(weights, weights + OpCount, 0);
+        std::string mix = text;
+        for (size_t pos = 0; pos < mix.size();)
+        {
+            size_t comma = mix.find(',', pos);
+            std::string item = mix.substr(pos, comma == std::string::npos ? std::string::npos : comma - pos);
+            pos = comma == std::string::npos ? mix.size() : comma + 1;
+            size_t eq = item.find('=');
+            if (eq == std::string::npos)
+                return false;
+            int op = 0;
+            while (op < OpCount && item.compare(0, eq, kOpNames[op]) != 0)
+                ++op;
+            if (op == OpCount)
+                return false;
+            weights[op] = std::atoi(item.c_str() + eq + 1);
+        }
+        return std::any_of(weights, weights + OpCount, [](int w) { return w > 0; });
+    }
+
+    // Counts and throughput come from the raw samples, percentiles from
+    // `latency`, which may include backfilled ones.
+    void printRow(const char *name, const Histogram &raw, const Histogram &latency, uint64_t errors, uint64_t shed,
+                  double seconds)
+    {
+        std::printf("%-8s %10llu %8llu %8llu %10.1f %10.3f %10.3f %10.3f %10.3f\n", name,
+                    (unsigned long long)raw.total(), (unsigned long long)errors, (unsigned long long)shed,
+                    raw.total() / seconds, latency.percentile(50) / 1e6,
+                    latency.percentile(99) / 1e6, latency.percentile(99.9) / 1e6, latency.max() / 1e6);
+    }
+
+    // The total row again as key=value pairs, for scripts: new fields may be
+    // added, but a key never changes meaning.
+    void printSummary(const Histogram &raw, const Histogram &latency, uint64_t errors, uint64_t shed, double seconds)
+    {
+        std::printf("summary requests=%llu errors=%llu shed=%llu rps=%.1f p50_ms=%.3f p99_ms=%.3f p999_ms=%.3f "
+                    "max_ms=%.3f\n",
+                    (unsigned long long)raw.total(), (unsigned long long)errors, (unsigned long long)shed,
+                    raw.total() / seconds, latency.percentile(50) / 1e6, latency.percentile(99) / 1e6,
+                    latency.percentile(99.9) / 1e6, latency.max() / 1e6);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Options options;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!value)
+        {
+            std::fprintf(stderr, "missing value for %s\n", arg.c_str());
+            return 2;
+        }
+        ++i;
+        if (arg == "--host")
+            options.host = value;
+        else if (arg == "--port")
+            options.port = std::atoi(value);
+        else if (arg == "--threads")
+            options.threads = std::max(1, std::atoi(value));
+        else if (arg == "--duration")
+            options.duration = std::atof(value);
+        else if (arg == "--warmup")
+            options.warmup = std::atof(value);
+        else if (arg == "--rate")
+            options.rate = std::atof(value);
+        else if (arg == "--mix")
+        {
+            if (!parseMix(value, options.weights))
+            {
+                std::fprintf(stderr, "bad --mix, expected e.g. users=70,add=10,edit=10,delete=5,auth=5\n");
+                return 2;
+            }
+        }
+        else if (arg == "--users-path")
+            options.usersPath = value;
+        else if (arg == "--username")
+            options.username = value;
+        else if (arg == "--password")
+            options.password = value;
+        else
+        {
+            std::fprintf(stderr, "unknown option %s\n", arg.c_str());
+            return 2;
+        }
+    }
+
+    // Existing ids for /edit and /delete, dealt out round-robin so workers
+    // never delete the same row twice.
+    std::vector<std::vector<int64_t>> ids(options.threads);
+    {
+        Connection conn(options);
+        std::string authBody = "{\"username\":\"" + options.username + "\",\"password\":\"" + options.password + "\"}";
+        std::string setCookie, body;
+        if (conn.request("POST", "/auth", authBody, "", &setCookie) != 200)
+        {
+            std::fprintf(stderr, "cannot log in to %s:%d\n", options.host.c_str(), options.port);
+            return 1;
+        }
+        conn.request("GET", "/users?after_id=0&limit=1000", "", cookieValue(setCookie), nullptr, &body);
+        std::vector<int64_t> all = parseIds(body);
+        for (size_t i = 0; i < all.size(); ++i)
+            ids[i % options.threads].push_back(all[i]);
+    }
+
+    std::vector<WorkerStats> stats(options.threads);
+    std::vector<std::thread> threads;
+    Clock::time_point start = Clock::now();
+    Clock::time_point measureFrom = start + std::chrono::duration_cast<Clock::duration>(
+                                                std::chrono::duration<double>(options.warmup));
+    Clock::time_point end = measureFrom + std::chrono::duration_cast<Clock::duration>(
+                                              std::chrono::duration<double>(options.duration));
+    for (int i = 0; i < options.threads; ++i)
+        threads.emplace_back(worker, std::cref(options), i, start, measureFrom, end, std::move(ids[i]),
+                             std::ref(stats[i]));
+    Connection metricsConn(options);
+    std::this_thread::sleep_until(measureFrom);
+    int64_t allocationsBefore = scrapeAllocations(metricsConn);
+    for (auto &thread : threads)
+        thread.join();
+    int64_t allocationsAfter = scrapeAllocations(metricsConn);
+
+    Histogram perOp[OpCount], all;
+    uint64_t errors[OpCount] = {}, allErrors = 0, shed[OpCount] = {}, allShed = 0;
+    for (const WorkerStats &worker : stats)
+    {
+        for (int op = 0; op < OpCount; ++op)
+        {
+            perOp[op].merge(worker.latency[op]);
+            errors[op] += worker.errors[op];
+            shed[op] += worker.shed[op];
+        }
+    }
+    for (int op = 0; op < OpCount; ++op)
+    {
+        all.merge(perOp[op]);
+        allErrors += errors[op];
+        allShed += shed[op];
+    }
+
+    // Closed loop gets the after-the-fact correction; open loop already
+    // measured from the schedule.
+    bool closedLoop = options.rate <= 0;
+    uint64_t interval = closedLoop ? all.mean() : 0;
+
+    std::printf("mode: %s, threads: %d, duration: %.1fs, mix: users=%d add=%d edit=%d delete=%d auth=%d\n",
+                closedLoop ? "closed-loop" : "open-loop", options.threads, options.duration, options.weights[0],
+                options.weights[1], options.weights[2], options.weights[3], options.weights[4]);
+    if (closedLoop)
+        std::printf("latency corrected for coordinated omission at the mean service time, %.3f ms\n", interval / 1e6);
+    else
+        std::printf("target rate: %.1f req/s, latency measured from scheduled send time\n", options.rate);
+    std::printf("%-8s %10s %8s %8s %10s %10s %10s %10s %10s\n", "op", "requests", "errors", "shed", "req/s",
+                "p50 ms", "p99 ms", "p99.9 ms", "max ms");
+    for (int op = 0; op < OpCount; ++op)
+        if (perOp[op].total())
+            printRow(kOpNames[op], perOp[op], perOp[op].corrected(interval), errors[op], shed[op],
+                     options.duration);
+    printRow("total", all, all.corrected(interval), allErrors, allShed, options.duration);
+    if (closedLoop)
+        printRow("raw", all, all, allErrors, allShed, options.duration);
+    if (allocationsBefore >= 0 && allocationsAfter >= allocationsBefore && all.total())
+        std::printf("server heap allocations: %.1f per request\n",
+                    double(allocationsAfter - allocationsBefore) / all.total());
+    printSummary(all, all.corrected(interval), allErrors, allShed, options.duration);
+    return 0;
+}
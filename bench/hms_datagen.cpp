@@ -0,0 +1,292 @@
+// Fills a database with synthetic patients for benchmarking.
+//
+// The file is brought to the server's current schema first (migrateSchema),
+// so the result opens directly in crow_sqlite_crud. Values are skewed the way
+// a real clinic's are: diseases and names follow a Zipf distribution, visits
+// cluster in recent months with a thin tail going back years, weekends are
+// quiet, and appointment times fall on 15-minute slots in clinic hours.
+// There are at least --doctors doctors; nine patients in ten are assigned
+// to one, again Zipf-distributed, so a few doctors carry most of the load.
+//
+//   hms_datagen [--db hms.db] [--rows 1M] [--doctors 200] [--seed 1] [--batch 100000]
+//
+// --rows takes a plain count or a k/M suffix (10k, 1M, 10M). Rows are
+// appended to whatever the users table already holds.
+#include "db.h"
+#include "schema.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <random>
+#include <string>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+namespace
+{
+    const char *const kDiseases[] = {
+        "Hypertension", "Diabetes", "Influenza", "Common cold", "Asthma", "Migraine", "Gastritis",
+        "Back pain", "Allergic rhinitis", "Anxiety", "Depression", "Bronchitis", "Urinary tract infection",
+        "Dermatitis", "Arthritis", "Hypothyroidism", "Anemia", "Otitis media", "Conjunctivitis", "Sinusitis",
+        "Pneumonia", "Typhoid", "Dengue fever", "Malaria", "Tuberculosis", "Hepatitis B", "Hepatitis C",
+        "Kidney stones", "Gallstones", "Appendicitis", "Coronary artery disease", "Heart failure", "Stroke",
+        "Epilepsy", "Psoriasis", "Osteoporosis", "Glaucoma", "Cataract", "Chronic kidney disease", "COPD"};
+
+    const char *const kFirstNames[] = {
+        "Muhammad", "Ali", "Ahmed", "Fatima", "Ayesha", "Hassan", "Hussain", "Zainab", "Usman", "Maryam",
+        "Bilal", "Sana", "Omar", "Hira", "Hamza", "Amna", "Imran", "Sara", "Kamran", "Nadia", "Faisal", "Saima",
+        "Asad", "Rabia", "Tariq", "Iqra", "Zubair", "Mahnoor", "Waqas", "Simrah", "Danish", "Khadija", "Saad",
+        "Noor", "Adeel", "Sadia", "Junaid", "Farah", "Shahid", "Alina"};
+
+    const char *const kSpecialties[] = {
+        "General practice", "Internal medicine", "Pediatrics", "Cardiology", "Dermatology", "ENT",
+        "Gynecology", "Orthopedics", "Psychiatry", "Neurology", "Ophthalmology", "Gastroenterology"};
+
+    const char *const kLastNames[] = {
+        "Khan", "Ahmad", "Ali", "Hussain", "Shah", "Malik", "Butt", "Qureshi", "Sheikh", "Chaudhry", "Iqbal",
+        "Raza", "Abbasi", "Siddiqui", "Mirza", "Baig", "Javed", "Aslam", "Akhtar", "Rana", "Anwar", "Rehman",
+        "Bhatti", "Mughal", "Zaidi", "Naqvi", "Hashmi", "Awan", "Gill", "Dar"};
+
+    template <size_t N>
+    constexpr size_t countOf(const char *const (&)[N])
+    {
+        return N;
+    }
+
+    // Zipf(s) over ranks 0..n-1: rank k is picked with weight 1 / (k + 1)^s.
+    std::discrete_distribution<int> zipf(size_t n, double s)
+    {
+        std::vector<double> weights(n);
+        for (size_t k = 0; k < n; ++k)
+            weights[k] = 1.0 / std::pow(k + 1.0, s);
+        return std::discrete_distribution<int>(weights.begin(), weights.end());
+    }
+
+    bool parseCount(const char *text, long long &out)
+    {
+        char *end = nullptr;
+        double value = std::strtod(text, &end);
+        if (end == text || value < 0)
+            return false;
+        if (*end == 'k' || *end == 'K')
+            value *= 1e3, ++end;
+        else if (*end == 'm' || *end == 'M')
+            value *= 1e6, ++end;
+        if (*end)
+            return false;
+        out = (long long)value;
+        return true;
+    }
+
+    // Appointment dates: days before today drawn from an exponential with a
+    // 90-day mean (capped at five years), weekends mostly moved to Friday,
+    // times on the quarter hour between 08:00 and 16:45.
+    class DateSource
+    {
+    public:
+        explicit DateSource(std::mt19937_64 &rng) : rng_(rng), today_(std::time(nullptr) / 86400) {}
+
+        void next(std::string &date)
+        {
+            long long back = std::min<long long>((long long)ageDays_(rng_), 5 * 365);
+            long long day = today_ - back;
+            int weekday = (int)((day + 4) % 7);  // 1970-01-01 was a Thursday
+            if ((weekday == 6 || weekday == 0) && weekendKeep_(rng_) > 0.15)
+                day -= weekday == 6 ? 1 : 2;
+
+            time_t seconds = (time_t)day * 86400;
+            struct tm tm;
+            gmtime_r(&seconds, &tm);
+            int slot = slot_(rng_);
+            char buf[64];
+            std::snprintf(buf, sizeof(buf), "%04d-%02d-%02dT%02d:%02d", tm.tm_year + 1900, tm.tm_mon + 1,
+                          tm.tm_mday, 8 + slot / 4, 15 * (slot % 4));
+            date = buf;
+        }
+
+    private:
+        std::mt19937_64 &rng_;
+        long long today_;
+        std::exponential_distribution<double> ageDays_{1.0 / 90};
+        std::uniform_real_distribution<double> weekendKeep_{0.0, 1.0};
+        std::uniform_int_distribution<int> slot_{0, 35};
+    };
+}
+
+int main(int argc, char **argv)
+{
+    std::string path = "hms.db";
+    long long rows = 1000000;
+    unsigned long long seed = 1;
+    long long batch = 100000;
+    long long doctors = 200;
+    for (int i = 1; i < argc; i += 2)
+    {
+        std::string arg = argv[i];
+        bool ok = i + 1 < argc;
+        if (!ok)
+            ;
+        else if (arg == "--db")
+            path = argv[i + 1];
+        else if (arg == "--rows")
+            ok = parseCount(argv[i + 1], rows);
+        else if (arg == "--seed")
+            seed = std::strtoull(argv[i + 1], nullptr, 10);
+        else if (arg == "--doctors")
+            ok = parseCount(argv[i + 1], doctors);
+        else if (arg == "--batch")
+            ok = parseCount(argv[i + 1], batch) && batch > 0;
+        else
+            ok = false;
+        if (!ok)
+        {
+            std::fprintf(stderr, "usage: %s [--db hms.db] [--rows 1M] [--doctors 200] [--seed 1] [--batch 100000]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    DbPool pool(path);
+    std::unique_ptr<DbConnection> db = pool.open();
+    if (!db || !migrateSchema(*db))
+        return 1;
+
+    // Nothing else has the file open, so trade durability for speed while
+    // filling. The indexes and triggers on users (date and doctor indexes,
+    // FTS, patient_count and user_stats upkeep) are dropped for the fill and
+    // recreated from their stored SQL afterwards; rebuilding the search index
+    // in one pass is about ten times faster than maintaining it row by row. This is
+    // skipped when the table already holds more rows than are being added.
+    if (!db->exec("PRAGMA journal_mode=WAL; PRAGMA synchronous=OFF; PRAGMA cache_size=-262144;"
+                  "PRAGMA temp_store=MEMORY;"))
+        return 1;
+    long long existing = 0;
+    {
+        Stmt count(*db, "SELECT count(*) FROM users");
+        if (count && sqlite3_step(count) == SQLITE_ROW)
+            existing = sqlite3_column_int64(count, 0);
+    }
+    std::vector<std::pair<std::string, std::string>> derived;  // name, CREATE statement
+    if (rows >= existing)
+    {
+        Stmt select(*db, "SELECT name, sql FROM sqlite_schema WHERE tbl_name = 'users' AND type IN ('index', 'trigger') "
+                         "AND sql IS NOT NULL ORDER BY type");
+        while (select && sqlite3_step(select) == SQLITE_ROW)
+            derived.emplace_back(reinterpret_cast<const char *>(sqlite3_column_text(select, 0)),
+                                 reinterpret_cast<const char *>(sqlite3_column_text(select, 1)));
+    }
+    for (const auto &object : derived)
+    {
+        std::string drop = (object.second.compare(0, 14, "CREATE TRIGGER") == 0 ? "DROP TRIGGER \"" : "DROP INDEX \"") +
+                           object.first + "\";";
+        if (!db->exec(drop.c_str()))
+            return 1;
+    }
+
+    std::mt19937_64 rng(seed);
+    auto disease = zipf(countOf(kDiseases), 1.1);
+    auto firstName = zipf(countOf(kFirstNames), 0.8);
+    auto lastName = zipf(countOf(kLastNames), 0.9);
+    std::uniform_int_distribution<int> network(300, 349);
+    std::uniform_int_distribution<int> subscriber(0, 9999999);
+    DateSource dates(rng);
+    std::string name, phone, date;
+
+    // Top the doctors table up to --doctors rows and collect their ids.
+    std::vector<sqlite3_int64> doctorIds;
+    {
+        Stmt select(*db, "SELECT id FROM doctors ORDER BY id");
+        while (select && sqlite3_step(select) == SQLITE_ROW)
+            doctorIds.push_back(sqlite3_column_int64(select, 0));
+    }
+    if ((long long)doctorIds.size() < doctors)
+    {
+        std::uniform_int_distribution<size_t> specialty(0, countOf(kSpecialties) - 1);
+        if (!db->exec("BEGIN;"))
+            return 1;
+        Stmt insert(*db, "INSERT INTO doctors (name, specialty) VALUES (?, ?)");
+        while (insert && (long long)doctorIds.size() < doctors)
+        {
+            name = "Dr. ";
+            name += kFirstNames[firstName(rng)];
+            name += ' ';
+            name += kLastNames[lastName(rng)];
+            sqlite3_bind_text(insert, 1, name.c_str(), name.size(), SQLITE_STATIC);
+            sqlite3_bind_text(insert, 2, kSpecialties[specialty(rng)], -1, SQLITE_STATIC);
+            if (sqlite3_step(insert) != SQLITE_DONE)
+                return 1;
+            sqlite3_reset(insert);
+            doctorIds.push_back(sqlite3_last_insert_rowid(db->handle()));
+        }
+        if (!db->exec("COMMIT;"))
+            return 1;
+    }
+    auto doctor = zipf(std::max<size_t>(doctorIds.size(), 1), 1.0);
+    std::uniform_real_distribution<double> assigned(0.0, 1.0);
+
+    Clock::time_point started = Clock::now();
+    char buf[64];
+    for (long long done = 0; done < rows;)
+    {
+        if (!db->exec("BEGIN;"))
+            return 1;
+        Stmt insert(*db, "INSERT INTO users (name, phone, disease, date, date_iso, doctor_id) VALUES (?, ?, ?, ?, ?, ?)");
+        if (!insert)
+            return 1;
+        long long end = std::min(rows, done + batch);
+        for (; done < end; ++done)
+        {
+            name = kFirstNames[firstName(rng)];
+            name += ' ';
+            name += kLastNames[lastName(rng)];
+            std::snprintf(buf, sizeof(buf), "+92-%d-%07d", network(rng), subscriber(rng));
+            phone = buf;
+            dates.next(date);
+
+            sqlite3_bind_text(insert, 1, name.c_str(), name.size(), SQLITE_STATIC);
+            sqlite3_bind_text(insert, 2, phone.c_str(), phone.size(), SQLITE_STATIC);
+            sqlite3_bind_text(insert, 3, kDiseases[disease(rng)], -1, SQLITE_STATIC);
+            sqlite3_bind_text(insert, 4, date.c_str(), date.size(), SQLITE_STATIC);
+            sqlite3_bind_text(insert, 5, date.c_str(), date.size(), SQLITE_STATIC);
+            if (!doctorIds.empty() && assigned(rng) < 0.9)
+                sqlite3_bind_int64(insert, 6, doctorIds[doctor(rng)]);
+            else
+                sqlite3_bind_null(insert, 6);
+            if (sqlite3_step(insert) != SQLITE_DONE)
+            {
+                std::fprintf(stderr, "insert failed: %s\n", sqlite3_errmsg(db->handle()));
+                return 1;
+            }
+            sqlite3_reset(insert);
+        }
+        if (!db->exec("COMMIT;"))
+            return 1;
+        std::fprintf(stderr, "\r%lld / %lld rows", done, rows);
+    }
+    double insertSeconds = std::chrono::duration<double>(Clock::now() - started).count();
+
+    Clock::time_point indexed = Clock::now();
+    for (const auto &object : derived)
+    {
+        if (!db->exec(object.second.c_str()))
+            return 1;
+    }
+    // With the triggers gone during the fill, the search index, the
+    // per-doctor counts and the /stats counts are rebuilt here instead.
+    if (!derived.empty() &&
+        (!db->exec("INSERT INTO users_fts (users_fts) VALUES ('rebuild');"
+                   "UPDATE doctors SET patient_count = (SELECT count(*) FROM users WHERE doctor_id = doctors.id);") ||
+         !rebuildUserStats(*db)))
+        return 1;
+    if (!db->exec("PRAGMA optimize; PRAGMA wal_checkpoint(TRUNCATE);"))
+        return 1;
+    double indexSeconds = std::chrono::duration<double>(Clock::now() - indexed).count();
+
+    std::fprintf(stderr, "\n");
+    std::printf("inserted %lld rows into %s in %.2fs (%.0f rows/s), indexes rebuilt in %.2fs\n", rows,
+                path.c_str(), insertSeconds, rows / std::max(insertSeconds, 1e-9), indexSeconds);
+    return 0;
+}
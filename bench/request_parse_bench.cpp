@@ -0,0 +1,137 @@
+// Compares how the write handlers read a request body: crow::json::load with
+// the fields copied into std::strings, as they used to, against JsonView over
+// the thread's RequestArena. Reports time and heap allocations per request
+// for an /add body, an /edit body with escapes, and a 100-operation /batch.
+#include "crow.h"
+#include "alloc_count.h"
+#include "arena.h"
+#include "json_view.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+namespace
+{
+    const char *const kFields[4] = {"name", "phone", "disease", "date"};
+
+    struct OwnedPatient
+    {
+        std::string name, phone, disease, date;
+    };
+
+    struct ViewPatient
+    {
+        std::string_view name, phone, disease, date;
+    };
+
+    // Sums field lengths so the optimizer cannot drop the parse.
+    size_t readCrow(const std::string &body)
+    {
+        auto json = crow::json::load(body);
+        if (!json)
+            return 0;
+        std::vector<OwnedPatient> patients;
+        auto readOne = [&](const crow::json::rvalue &item) {
+            OwnedPatient patient;
+            std::string *values[4] = {&patient.name, &patient.phone, &patient.disease, &patient.date};
+            for (int i = 0; i < 4; ++i)
+                if (item.has(kFields[i]))
+                    *values[i] = item[kFields[i]].s();
+            patients.push_back(std::move(patient));
+        };
+        if (json.t() == crow::json::type::List)
+            for (const auto &item : json)
+                readOne(item);
+        else
+            readOne(json);
+        size_t total = 0;
+        for (const OwnedPatient &patient : patients)
+            total += patient.name.size() + patient.phone.size() + patient.disease.size() + patient.date.size();
+        return total;
+    }
+
+    size_t readView(const std::string &body)
+    {
+        ArenaScope scope;
+        JsonView json(scope.arena());
+        if (!json.parse(body))
+            return 0;
+        std::pmr::vector<ViewPatient> patients(scope.arena().resource());
+        auto readOne = [&](JsonView::Value item) {
+            ViewPatient patient;
+            std::string_view *values[4] = {&patient.name, &patient.phone, &patient.disease, &patient.date};
+            for (int i = 0; i < 4; ++i)
+                *values[i] = item[kFields[i]].s();
+            patients.push_back(patient);
+        };
+        JsonView::Value root = json.root();
+        if (root.t() == JsonView::Type::List)
+        {
+            patients.reserve(root.size());
+            for (JsonView::Value item : root)
+                readOne(item);
+        }
+        else
+            readOne(root);
+        size_t total = 0;
+        for (const ViewPatient &patient : patients)
+            total += patient.name.size() + patient.phone.size() + patient.disease.size() + patient.date.size();
+        return total;
+    }
+
+    std::string patientJson(int i, bool escaped)
+    {
+        std::string name = "Patient " + std::to_string(i);
+        if (escaped)
+            name += " \\\"M\\u00fcller\\\"";
+        return "{\"op\":\"add\",\"name\":\"" + name + "\",\"phone\":\"+92-300-" + std::to_string(1000000 + i) +
+               "\",\"disease\":\"Influenza and a longer free-text note about symptoms\",\"date\":\"2025-03-07 09:30\"}";
+    }
+
+    template <typename F>
+    void run(const char *name, const std::string &body, int iterations, F &&read)
+    {
+        size_t check = read(body);  // warm the arena and allocator
+        uint64_t allocations = allocationCount();
+        auto start = Clock::now();
+        for (int i = 0; i < iterations; ++i)
+            check += read(body);
+        double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / iterations;
+        double perRequest = double(allocationCount() - allocations) / iterations;
+        std::printf("  %-12s %12.0f %14.1f %12zu\n", name, ns, perRequest, check / (iterations + 1));
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 100000;
+
+    std::string batch = "[";
+    for (int i = 0; i < 100; ++i)
+        batch += (i ? "," : "") + patientJson(i, i % 10 == 0);
+    batch += "]";
+    struct
+    {
+        const char *name;
+        std::string body;
+        int iterations;
+    } cases[] = {
+        {"/add", patientJson(1, false), iterations},
+        {"/edit", patientJson(2, true), iterations},
+        {"/batch x100", batch, iterations / 100 ? iterations / 100 : 1},
+    };
+
+    for (const auto &c : cases)
+    {
+        std::printf("%s (%zu byte body)\n  %-12s %12s %14s %12s\n", c.name, c.body.size(), "parser", "ns/request",
+                    "allocs/request", "field bytes");
+        run("crow::json", c.body, c.iterations, readCrow);
+        run("JsonView", c.body, c.iterations, readView);
+    }
+}
@@ -0,0 +1,75 @@
+#!/usr/bin/env bash
+# Measures how the server behaves as the users table grows. For each size it
+# generates a fresh database with hms_datagen, starts crow_sqlite_crud on it
+# and records:
+#   - startup time until /health answers
+#   - resident memory when idle and after the /users run
+#   - /users throughput and p50/p99/p99.9 latency (hms_bench, reads only)
+#   - /add throughput and p99 latency (hms_bench, inserts only)
+# One CSV row per size is appended to the results file.
+#
+# usage: bench/scaling_suite.sh [build-dir] [size...]
+#   env: DURATION (seconds per run, default 10), THREADS (default 8),
+#        RESULTS (default scaling-results.csv)
+set -euo pipefail
+
+BUILD_DIR="$(cd "${1:-build}" && pwd)"
+shift || true
+SIZES=("$@")
+if [ ${#SIZES[@]} -eq 0 ]; then
+  SIZES=(10k 1M 10M)
+fi
+DURATION="${DURATION:-10}"
+THREADS="${THREADS:-8}"
+RESULTS="${RESULTS:-scaling-results.csv}"
+URL="http://127.0.0.1:3000"
+
+if [ ! -f "$RESULTS" ]; then
+  echo "size,startup_ms,rss_idle_kb,users_rps,users_p50_ms,users_p99_ms,users_p999_ms,rss_after_users_kb,insert_rps,insert_p99_ms" > "$RESULTS"
+fi
+
+rss_kb() {
+  awk '/^VmRSS:/ { print $2 }' "/proc/$1/status"
+}
+
+# Prints hms_bench's summary line as: req/s p50 p99 p99.9. Fields are looked
+# up by key, so columns added to the report cannot shift them.
+bench_total() {
+  "$BUILD_DIR/hms_bench" --threads "$THREADS" --duration "$DURATION" --warmup 2 "$@" |
+    awk '$1 == "summary" {
+      for (i = 2; i <= NF; i++) { split($i, kv, "="); v[kv[1]] = kv[2] }
+      print v["rps"], v["p50_ms"], v["p99_ms"], v["p999_ms"]
+    }'
+}
+
+for size in "${SIZES[@]}"; do
+  work="$(mktemp -d)"
+  echo "== $size (in $work)"
+  "$BUILD_DIR/hms_datagen" --db "$work/hms.db" --rows "$size"
+
+  start_ns=$(date +%s%N)
+  (cd "$work" && exec "$BUILD_DIR/crow_sqlite_crud" > server.log 2>&1) &
+  server=$!
+  trap 'kill $server 2>/dev/null || true' EXIT
+  until curl -sf "$URL/health" > /dev/null; do
+    if ! kill -0 "$server" 2>/dev/null; then
+      echo "server exited during startup; see $work/server.log" >&2
+      exit 1
+    fi
+    sleep 0.05
+  done
+  startup_ms=$(( ($(date +%s%N) - start_ns) / 1000000 ))
+  rss_idle=$(rss_kb "$server")
+
+  read -r users_rps users_p50 users_p99 users_p999 < <(bench_total --mix users=100)
+  rss_after=$(rss_kb "$server")
+  read -r insert_rps _ insert_p99 _ < <(bench_total --mix add=100)
+
+  kill "$server"
+  wait "$server" 2>/dev/null || true
+  trap - EXIT
+
+  echo "$size,$startup_ms,$rss_idle,$users_rps,$users_p50,$users_p99,$users_p999,$rss_after,$insert_rps,$insert_p99" |
+    tee -a "$RESULTS"
+  rm -rf "$work"
+done
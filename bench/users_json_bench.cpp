@@ -0,0 +1,126 @@
+// Compares the old crow::json::wvalue serialization of /users against the
+// direct-to-buffer JsonWriter path, on an in-memory table of 10k, 100k and
+// 1M rows (or the row counts given on the command line).
+#include "crow.h"
+#include "user_rows.h"
+
+#include <sqlite3.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static void fillUsers(sqlite3 *db, int rows)
+{
+    sqlite3_exec(db, "DROP TABLE IF EXISTS users;"
+                     "CREATE TABLE users (id INTEGER PRIMARY KEY AUTOINCREMENT, name TEXT NOT NULL, "
+                     "phone TEXT NOT NULL, disease TEXT NOT NULL, date TEXT NOT NULL);"
+                     "BEGIN;",
+                 nullptr, nullptr, nullptr);
+    sqlite3_stmt *stmt;
+    sqlite3_prepare_v2(db, "INSERT INTO users (name, phone, disease, date) VALUES (?, ?, ?, ?)", -1, &stmt, nullptr);
+    static const char *diseases[] = {"Influenza", "Diabetes \"type 2\"", "Hypertension", "Asthma", "Migraine"};
+    for (int i = 0; i < rows; ++i)
+    {
+        std::string name = "Patient " + std::to_string(i);
+        std::string phone = "+92-300-" + std::to_string(1000000 + i);
+        std::string date = "2025-" + std::to_string(1 + i % 12) + "-" + std::to_string(1 + i % 28);
+        sqlite3_bind_text(stmt, 1, name.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 2, phone.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 3, diseases[i % 5], -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 4, date.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_step(stmt);
+        sqlite3_reset(stmt);
+    }
+    sqlite3_finalize(stmt);
+    sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr);
+}
+
+// The handler as it was: one wvalue per row, pushed by value, dumped at the end.
+static size_t serializeWvalue(sqlite3_stmt *stmt)
+{
+    crow::json::wvalue result;
+    crow::json::wvalue::list users;
+    while (sqlite3_step(stmt) == SQLITE_ROW)
+    {
+        crow::json::wvalue user;
+        user["id"] = sqlite3_column_int(stmt, 0);
+        user["name"] = (const char *)sqlite3_column_text(stmt, 1);
+        user["phone"] = (const char *)sqlite3_column_text(stmt, 2);
+        user["disease"] = (const char *)sqlite3_column_text(stmt, 3);
+        user["date"] = (const char *)sqlite3_column_text(stmt, 4);
+        users.push_back(user);
+    }
+    sqlite3_reset(stmt);
+    result = std::move(users);
+    return result.dump().size();
+}
+
+static size_t serializeWriter(sqlite3_stmt *stmt)
+{
+    std::string body;
+    body.push_back('[');
+    bool first = true;
+    while (sqlite3_step(stmt) == SQLITE_ROW)
+    {
+        if (!first)
+            body.push_back(',');
+        first = false;
+        appendUserJson(body, stmt);
+    }
+    body.push_back(']');
+    sqlite3_reset(stmt);
+    return body.size();
+}
+
+template <typename F>
+static double bestOf(int runs, F &&f, size_t &bytes)
+{
+    double best = 1e300;
+    for (int i = 0; i < runs; ++i)
+    {
+        auto start = Clock::now();
+        bytes = f();
+        best = std::min(best, std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+    }
+    return best;
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<int> sizes = {10000, 100000, 1000000};
+    if (argc > 1)
+    {
+        sizes.clear();
+        for (int i = 1; i < argc; ++i)
+            sizes.push_back(std::atoi(argv[i]));
+    }
+
+    sqlite3 *db;
+    if (sqlite3_open(":memory:", &db) != SQLITE_OK)
+        return 1;
+
+    std::printf("%10s %14s %14s %10s %12s\n", "rows", "wvalue ms", "writer ms", "speedup", "body MiB");
+    for (int rows : sizes)
+    {
+        fillUsers(db, rows);
+        sqlite3_stmt *stmt;
+        sqlite3_prepare_v2(db, "SELECT id, name, phone, disease, date FROM users", -1, &stmt, nullptr);
+
+        int runs = rows >= 1000000 ? 3 : 5;
+        size_t wvalueBytes = 0, writerBytes = 0;
+        double wvalueMs = bestOf(runs, [&] { return serializeWvalue(stmt); }, wvalueBytes);
+        double writerMs = bestOf(runs, [&] { return serializeWriter(stmt); }, writerBytes);
+        sqlite3_finalize(stmt);
+
+        std::printf("%10d %14.2f %14.2f %9.1fx %12.2f\n", rows, wvalueMs, writerMs, wvalueMs / writerMs,
+                    writerBytes / (1024.0 * 1024.0));
+        if (wvalueBytes != writerBytes)
+            std::printf("%10s note: wvalue body is %zu bytes, writer body %zu bytes\n", "", wvalueBytes, writerBytes);
+    }
+
+    sqlite3_close(db);
+}
@@ -0,0 +1,218 @@
+#include "bulk_import.h"
+
+#include "dates.h"
+#include "json_view.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <strings.h>
+
+namespace
+{
+    const char *const kColumnNames[4] = {"name", "phone", "disease", "date"};
+
+    std::string_view trim(std::string_view text)
+    {
+        size_t begin = 0, end = text.size();
+        while (begin < end && std::isspace(static_cast<unsigned char>(text[begin])))
+            ++begin;
+        while (end > begin && std::isspace(static_cast<unsigned char>(text[end - 1])))
+            --end;
+        return text.substr(begin, end - begin);
+    }
+
+    // Rejects records with empty fields and normalizes the date of the rest.
+    void finishRecord(BulkRecord &record)
+    {
+        Patient &patient = record.patient;
+        if (record.error.empty() &&
+            (patient.name.empty() || patient.phone.empty() || patient.disease.empty() || patient.date.empty()))
+            record.error = "name, phone, disease and date are required";
+        if (record.error.empty())
+            normalizeDate(patient.date, patient.dateIso);
+    }
+}
+
+BulkReader::BulkReader(const std::string &body, Format format, RequestArena &arena)
+    : body_(body), format_(format), arena_(arena)
+{
+}
+
+bool BulkReader::next(BulkRecord &record)
+{
+    return format_ == Format::Csv ? nextCsv(record) : nextNdjson(record);
+}
+
+bool BulkReader::nextNdjson(BulkRecord &record)
+{
+    while (pos_ < body_.size())
+    {
+        size_t end = body_.find('\n', pos_);
+        if (end == std::string::npos)
+            end = body_.size();
+        size_t begin = pos_;
+        size_t line = line_++;
+        pos_ = end + 1;
+
+        while (begin < end && std::isspace(static_cast<unsigned char>(body_[begin])))
+            ++begin;
+        if (begin == end)
+            continue;
+
+        record = BulkRecord();
+        record.line = line;
+        JsonView json(arena_);
+        JsonView::Value row;
+        if (!json.parse(std::string_view(body_).substr(begin, end - begin)) ||
+            (row = json.root()).t() != JsonView::Type::Object)
+        {
+            record.error = "invalid JSON";
+            return true;
+        }
+        std::string_view *fields[4] = {&record.patient.name, &record.patient.phone, &record.patient.disease,
+                                       &record.patient.date};
+        for (int i = 0; i < 4; ++i)
+        {
+            JsonView::Value value = row[kColumnNames[i]];
+            if (value.t() != JsonView::Type::String)
+            {
+                record.error = std::string("missing or non-string ") + kColumnNames[i];
+                return true;
+            }
+            *fields[i] = value.s();
+        }
+        finishRecord(record);
+        return true;
+    }
+    return false;
+}
+
+// The field between `begin` and `end` in the body. A plain field (no quotes
+// or carriage returns) is a view of the body; anything else is unquoted into
+// the arena, with doubled quotes inside quoted text read as one.
+std::string_view BulkReader::csvField(size_t begin, size_t end, bool plain)
+{
+    std::string_view raw = std::string_view(body_).substr(begin, end - begin);
+    if (plain)
+    {
+        if (!raw.empty() && raw.back() == '\r')
+            raw.remove_suffix(1);
+        return raw;
+    }
+    char *out = arena_.allocate(raw.size());
+    size_t len = 0;
+    bool quoted = false;
+    for (size_t i = 0; i < raw.size(); ++i)
+    {
+        char c = raw[i];
+        if (c == '"')
+        {
+            if (quoted && i + 1 < raw.size() && raw[i + 1] == '"')
+                out[len++] = raw[++i];
+            else
+                quoted = !quoted;
+        }
+        else if (quoted || c != '\r')
+            out[len++] = c;
+    }
+    return std::string_view(out, len);
+}
+
+bool BulkReader::readCsvRow(std::vector<std::string_view> &fields)
+{
+    fields.clear();
+    if (pos_ >= body_.size())
+        return false;
+
+    size_t fieldStart = pos_;
+    bool plain = true;
+    bool quoted = false;
+    while (pos_ < body_.size())
+    {
+        char c = body_[pos_++];
+        if (c == '"')
+        {
+            plain = false;
+            if (quoted && pos_ < body_.size() && body_[pos_] == '"')
+                ++pos_;
+            else
+                quoted = !quoted;
+        }
+        else if (c == '\n')
+        {
+            ++line_;
+            if (!quoted)
+            {
+                fields.push_back(csvField(fieldStart, pos_ - 1, plain));
+                return true;
+            }
+        }
+        else if (quoted)
+        {
+            continue;
+        }
+        else if (c == ',')
+        {
+            fields.push_back(csvField(fieldStart, pos_ - 1, plain));
+            fieldStart = pos_;
+            plain = true;
+        }
+        else if (c == '\r')
+        {
+            // A CRLF line ending is trimmed off the view; a stray CR is
+            // dropped by unquoting.
+            if (pos_ < body_.size() && body_[pos_] != '\n')
+                plain = false;
+        }
+    }
+    fields.push_back(csvField(fieldStart, pos_, plain));
+    return true;
+}
+
+bool BulkReader::nextCsv(BulkRecord &record)
+{
+    for (;;)
+    {
+        size_t line = line_;
+        if (!readCsvRow(row_))
+            return false;
+        if (row_.size() == 1 && trim(row_[0]).empty())
+            continue;
+
+        if (!headerChecked_)
+        {
+            headerChecked_ = true;
+            int found[4] = {-1, -1, -1, -1};
+            for (size_t col = 0; col < row_.size(); ++col)
+            {
+                std::string_view name = trim(row_[col]);
+                for (int i = 0; i < 4; ++i)
+                    if (name.size() == std::strlen(kColumnNames[i]) &&
+                        strncasecmp(name.data(), kColumnNames[i], name.size()) == 0)
+                        found[i] = col;
+            }
+            if (std::find(found, found + 4, -1) == found + 4)
+            {
+                std::copy(found, found + 4, columns_);
+                continue;
+            }
+        }
+
+        record = BulkRecord();
+        record.line = line;
+        std::string_view *fields[4] = {&record.patient.name, &record.patient.phone, &record.patient.disease,
+                                       &record.patient.date};
+        for (int i = 0; i < 4; ++i)
+        {
+            if ((size_t)columns_[i] >= row_.size())
+            {
+                record.error = std::string("missing column ") + kColumnNames[i];
+                return true;
+            }
+            *fields[i] = trim(row_[columns_[i]]);
+        }
+        finishRecord(record);
+        return true;
+    }
+}
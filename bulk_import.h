@@ -0,0 +1,58 @@
+#pragma once
+
+#include "arena.h"
+#include "patients.h"
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// One patient record pulled out of a bulk upload.
+struct BulkRecord
+{
+    size_t line = 0;       // line the record starts on, 1-based
+    Patient patient;
+    std::string error;     // non-empty if the record was rejected
+};
+
+// Reads patient records one at a time from an NDJSON or CSV upload.
+//
+// NDJSON is one object per line with name, phone, disease and date. CSV
+// follows RFC 4180 quoting (quoted fields may contain commas, quotes and
+// newlines); an optional header row maps columns by name, otherwise columns
+// are taken as name,phone,disease,date. Nothing beyond the current record is
+// materialized, so memory use does not grow with the size of the upload.
+//
+// Record fields are views into the body where possible; JSON strings with
+// escapes and CSV fields with quotes are unescaped into `arena`, which the
+// caller may release once it is done with the records read so far.
+class BulkReader
+{
+public:
+    enum class Format
+    {
+        Ndjson,
+        Csv
+    };
+
+    BulkReader(const std::string &body, Format format, RequestArena &arena);
+
+    // Fills `record` with the next record; returns false at end of input.
+    bool next(BulkRecord &record);
+
+private:
+    bool nextNdjson(BulkRecord &record);
+    bool nextCsv(BulkRecord &record);
+    bool readCsvRow(std::vector<std::string_view> &fields);
+    std::string_view csvField(size_t begin, size_t end, bool plain);
+
+    const std::string &body_;
+    Format format_;
+    RequestArena &arena_;
+    size_t pos_ = 0;
+    size_t line_ = 1;
+    bool headerChecked_ = false;
+    int columns_[4] = {0, 1, 2, 3};
+    std::vector<std::string_view> row_;
+};
@@ -0,0 +1,194 @@
+#include "change_feed.h"
+
+#include "json_writer.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <map>
+
+namespace
+{
+    // Sent with every response: how long EventSource waits before it polls
+    // again. Kept short because the poll itself does the waiting.
+    const char kRetryFrame[] = "retry: 100\n\n";
+
+    void endWith(crow::response &res, std::string body)
+    {
+        res.code = 200;
+        res.set_header("Content-Type", "text/event-stream");
+        res.set_header("Cache-Control", "no-cache");
+        res.body = std::move(body);
+        res.end();
+    }
+}
+
+ChangeFeed::ChangeFeed(size_t capacity, std::chrono::seconds pollTimeout)
+    : capacity_(capacity), pollTimeout_(pollTimeout)
+{
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+    epoch_ = std::to_string(std::chrono::duration_cast<std::chrono::microseconds>(now).count());
+}
+
+std::string ChangeFeed::eventId(uint64_t seq) const
+{
+    return epoch_ + "-" + std::to_string(seq);
+}
+
+void ChangeFeed::start()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_)
+        return;
+    running_ = true;
+    thread_ = std::thread(&ChangeFeed::dispatch, this);
+}
+
+void ChangeFeed::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_)
+            return;
+        running_ = false;
+    }
+    wake_.notify_one();
+    thread_.join();
+}
+
+void ChangeFeed::publish(const char *op, int64_t id, std::string rowJson)
+{
+    std::string data;
+    JsonWriter json(data);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        uint64_t seq = ++lastSeq_;
+        data.append("id: ");
+        data.append(eventId(seq));
+        data.append("\nevent: change\ndata: {");
+        json.key("seq");
+        json.integer(seq);
+        json.raw(',');
+        json.key("op");
+        json.string(op, std::char_traits<char>::length(op));
+        json.raw(',');
+        json.key("id");
+        json.integer(id);
+        json.raw(',');
+        json.key("row");
+        if (rowJson.empty())
+            json.null();
+        else
+            json.raw(rowJson.data(), rowJson.size());
+        data.append("}\n\n");
+
+        events_.push_back(Event{seq, std::move(data)});
+        if (events_.size() > capacity_)
+            events_.pop_front();
+    }
+    wake_.notify_one();
+}
+
+std::string ChangeFeed::framesAfter(uint64_t since) const
+{
+    std::string body;
+    if (since > lastSeq_ || (!events_.empty() && since + 1 < events_.front().seq))
+    {
+        // A position we no longer hold: have the client reload the full list
+        // and continue from the current position.
+        body = "id: " + eventId(lastSeq_) + "\nevent: reset\ndata: {}\n\n";
+    }
+    else
+    {
+        auto it = std::lower_bound(events_.begin(), events_.end(), since + 1,
+                                   [](const Event &event, uint64_t seq) { return event.seq < seq; });
+        for (; it != events_.end(); ++it)
+            body.append(it->text);
+    }
+    if (!body.empty())
+        body.append(kRetryFrame);
+    return body;
+}
+
+void ChangeFeed::subscribe(const std::string &lastEventId, crow::response &res)
+{
+    // Anything that is not one of our ids (including no id at all) maps past
+    // the end, which framesAfter answers with a reset.
+    uint64_t since = UINT64_MAX;
+    size_t dash = lastEventId.find('-');
+    if (dash != std::string::npos && lastEventId.compare(0, dash, epoch_) == 0)
+    {
+        char *end = nullptr;
+        unsigned long long seq = std::strtoull(lastEventId.c_str() + dash + 1, &end, 10);
+        if (end != lastEventId.c_str() + dash + 1 && *end == '\0')
+            since = seq;
+    }
+
+    std::string body;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_)
+        {
+            res.code = 503;
+            res.end();
+            return;
+        }
+        body = framesAfter(since);
+        if (body.empty())
+        {
+            waiters_.push_back(Waiter{&res, since, std::chrono::steady_clock::now() + pollTimeout_});
+            return;
+        }
+    }
+    endWith(res, std::move(body));
+}
+
+void ChangeFeed::dispatch()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (running_)
+    {
+        wake_.wait_for(lock, std::chrono::seconds(1));
+
+        auto now = std::chrono::steady_clock::now();
+        std::vector<std::pair<crow::response *, std::string>> ready;
+        // Most waiters are at the same position; build each body once.
+        std::map<uint64_t, std::string> bodies;
+        for (auto it = waiters_.begin(); it != waiters_.end();)
+        {
+            // Waiters are parked only when fully caught up, so any newer
+            // event makes them due.
+            bool due = it->since < lastSeq_;
+            if (due || it->deadline <= now)
+            {
+                std::string body;
+                if (due)
+                {
+                    auto cached = bodies.find(it->since);
+                    if (cached == bodies.end())
+                        cached = bodies.emplace(it->since, framesAfter(it->since)).first;
+                    body = cached->second;
+                }
+                else
+                {
+                    body = std::string(": keep-alive\n") + kRetryFrame;
+                }
+                ready.emplace_back(it->res, std::move(body));
+                it = waiters_.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+
+        // Ending a response starts Crow's write on that connection; do it
+        // without holding the lock publishers need.
+        lock.unlock();
+        for (auto &entry : ready)
+            endWith(*entry.first, std::move(entry.second));
+        lock.lock();
+    }
+    // Stopping means the server is shutting down and its connections are
+    // gone; there is nobody left to answer.
+    waiters_.clear();
+}
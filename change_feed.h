@@ -0,0 +1,81 @@
+#pragma once
+
+#include "crow.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Sequence-numbered log of recent users changes, delivered to dashboards as
+// Server-Sent Events.
+//
+// Crow cannot keep writing to a response after the handler returns, so each
+// GET /users/changes is a long poll: if the client is behind it gets the
+// missing events at once, otherwise its response is parked until the next
+// change (or a keep-alive timeout) and then ended. EventSource reconnects on
+// its own and sends Last-Event-ID, so the browser sees one continuous stream
+// and each change costs O(changed rows) per client rather than a table reload.
+// A client that has fallen out of the retained window gets a `reset` event
+// and reloads the list once.
+class ChangeFeed
+{
+public:
+    explicit ChangeFeed(size_t capacity = 4096,
+                        std::chrono::seconds pollTimeout = std::chrono::seconds(25));
+    ~ChangeFeed() { stop(); }
+
+    ChangeFeed(const ChangeFeed &) = delete;
+    ChangeFeed &operator=(const ChangeFeed &) = delete;
+
+    void start();
+    void stop();
+
+    // Records a change; called from the writer's commit hooks, so sequence
+    // numbers follow commit order. `rowJson` is the row object, or empty for
+    // a delete.
+    void publish(const char *op, int64_t id, std::string rowJson);
+
+    // Answers `res` with every event after the one named by `lastEventId`
+    // (the Last-Event-ID header, or empty for a new client), now or as soon
+    // as one arrives.
+    void subscribe(const std::string &lastEventId, crow::response &res);
+
+private:
+    struct Event
+    {
+        uint64_t seq;
+        std::string text;  // the full SSE frame
+    };
+
+    struct Waiter
+    {
+        crow::response *res;
+        uint64_t since;
+        std::chrono::steady_clock::time_point deadline;
+    };
+
+    // SSE frames for everything after `since`, or a reset frame if `since`
+    // is not in the retained window; caller holds mutex_.
+    std::string framesAfter(uint64_t since) const;
+    std::string eventId(uint64_t seq) const;
+    void dispatch();
+
+    size_t capacity_;
+    std::chrono::seconds pollTimeout_;
+    // Event ids are "<epoch>-<seq>"; a client resuming from an earlier server
+    // process has a different epoch and is reset rather than mis-resumed.
+    std::string epoch_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::deque<Event> events_;
+    uint64_t lastSeq_ = 0;
+    std::vector<Waiter> waiters_;
+    bool running_ = false;
+    std::thread thread_;
+};
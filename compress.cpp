@@ -0,0 +1,138 @@
+#include "compress.h"
+
+#include "static_page.h"
+
+#include <zlib.h>
+#ifdef HMS_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include <cstring>
+
+namespace
+{
+    const int kGzipLevel = 4;
+    const int kZstdLevel = 3;
+
+    // Output is produced in pieces of this size.
+    const size_t kChunk = 64 * 1024;
+}
+
+struct StreamCompressor::State
+{
+    z_stream zs;
+#ifdef HMS_HAVE_ZSTD
+    ZSTD_CCtx *zstd = nullptr;
+#endif
+};
+
+ContentCoding negotiateCoding(const std::string &acceptEncoding)
+{
+    if (acceptEncoding.empty())
+        return ContentCoding::Identity;
+#ifdef HMS_HAVE_ZSTD
+    if (acceptsEncoding(acceptEncoding, "zstd"))
+        return ContentCoding::Zstd;
+#endif
+    if (acceptsEncoding(acceptEncoding, "gzip"))
+        return ContentCoding::Gzip;
+    return ContentCoding::Identity;
+}
+
+const char *codingName(ContentCoding coding)
+{
+    switch (coding)
+    {
+    case ContentCoding::Gzip: return "gzip";
+    case ContentCoding::Zstd: return "zstd";
+    default: return "identity";
+    }
+}
+
+StreamCompressor::StreamCompressor(ContentCoding coding) : coding_(coding), state_(new State())
+{
+    if (coding_ == ContentCoding::Gzip)
+    {
+        std::memset(&state_->zs, 0, sizeof(state_->zs));
+        // 15 window bits plus 16 selects the gzip wrapper instead of zlib's.
+        ready_ = deflateInit2(&state_->zs, kGzipLevel, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+    }
+#ifdef HMS_HAVE_ZSTD
+    else if (coding_ == ContentCoding::Zstd)
+    {
+        state_->zstd = ZSTD_createCCtx();
+        ready_ = state_->zstd &&
+                 !ZSTD_isError(ZSTD_CCtx_setParameter(state_->zstd, ZSTD_c_compressionLevel, kZstdLevel)) &&
+                 !ZSTD_isError(ZSTD_CCtx_setParameter(state_->zstd, ZSTD_c_checksumFlag, 1));
+    }
+#endif
+}
+
+StreamCompressor::~StreamCompressor()
+{
+    if (coding_ == ContentCoding::Gzip && ready_)
+        deflateEnd(&state_->zs);
+#ifdef HMS_HAVE_ZSTD
+    ZSTD_freeCCtx(state_->zstd);
+#endif
+}
+
+bool StreamCompressor::write(const char *data, size_t len, bool last, std::string &out)
+{
+    if (!ready_)
+        return false;
+
+    if (coding_ == ContentCoding::Gzip)
+    {
+        z_stream &zs = state_->zs;
+        zs.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+        zs.avail_in = static_cast<uInt>(len);
+        int flush = last ? Z_FINISH : Z_NO_FLUSH;
+        for (;;)
+        {
+            size_t used = out.size();
+            out.resize(used + kChunk);
+            zs.next_out = reinterpret_cast<Bytef *>(&out[used]);
+            zs.avail_out = static_cast<uInt>(kChunk);
+            int rc = deflate(&zs, flush);
+            out.resize(used + kChunk - zs.avail_out);
+            if (rc == Z_STREAM_ERROR)
+                return false;
+            if (last ? rc == Z_STREAM_END : zs.avail_out != 0)
+                return true;
+        }
+    }
+
+#ifdef HMS_HAVE_ZSTD
+    if (coding_ == ContentCoding::Zstd)
+    {
+        ZSTD_inBuffer in = {data, len, 0};
+        for (;;)
+        {
+            size_t used = out.size();
+            out.resize(used + kChunk);
+            ZSTD_outBuffer buffer = {&out[used], kChunk, 0};
+            size_t remaining = ZSTD_compressStream2(state_->zstd, &buffer, &in, last ? ZSTD_e_end : ZSTD_e_continue);
+            out.resize(used + buffer.pos);
+            if (ZSTD_isError(remaining))
+                return false;
+            if (last ? remaining == 0 : in.pos == in.size)
+                return true;
+        }
+    }
+#endif
+    return false;
+}
+
+ContentCoding compressBody(std::string &body, ContentCoding coding)
+{
+    if (coding == ContentCoding::Identity || body.size() < kCompressMinBytes)
+        return ContentCoding::Identity;
+    StreamCompressor compressor(coding);
+    std::string packed;
+    packed.reserve(body.size() / 4);
+    if (!compressor || !compressor.write(body.data(), body.size(), true, packed))
+        return ContentCoding::Identity;
+    body.swap(packed);
+    return coding;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+// Content-Encoding of a dynamic response body.
+enum class ContentCoding
+{
+    Identity,
+    Gzip,
+    Zstd,  // only when built with libzstd (HMS_HAVE_ZSTD)
+};
+
+// Bodies smaller than this are sent as they are: below about a packet the
+// saving cannot pay for the compressor's setup and the extra header.
+const size_t kCompressMinBytes = 1024;
+
+// The coding to use for a client's Accept-Encoding value: zstd if accepted
+// and compiled in, otherwise gzip if accepted, otherwise identity.
+ContentCoding negotiateCoding(const std::string &acceptEncoding);
+
+// Content-Encoding token for `coding`; "identity" for none.
+const char *codingName(ContentCoding coding);
+
+// Compresses a body incrementally, so a response can be encoded chunk by
+// chunk as it is produced instead of after it has been built in full. Both
+// codings use fast levels: these are dynamic bodies, compressed per request.
+class StreamCompressor
+{
+public:
+    explicit StreamCompressor(ContentCoding coding);
+    ~StreamCompressor();
+
+    StreamCompressor(const StreamCompressor &) = delete;
+    StreamCompressor &operator=(const StreamCompressor &) = delete;
+
+    // False if the coding is identity or the compressor could not be set up.
+    explicit operator bool() const { return ready_; }
+
+    // Compresses `len` bytes and appends whatever output is ready to `out`;
+    // `last` ends the stream and flushes the rest. Returns false on error.
+    bool write(const char *data, size_t len, bool last, std::string &out);
+
+private:
+    struct State;
+
+    ContentCoding coding_;
+    std::unique_ptr<State> state_;
+    bool ready_ = false;
+};
+
+// Compresses `body` in place with `coding` if it is at least
+// kCompressMinBytes long. Returns the coding actually applied.
+ContentCoding compressBody(std::string &body, ContentCoding coding);
@@ -0,0 +1,191 @@
+#include "config.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <initializer_list>
+#include <iostream>
+#include <thread>
+
+namespace
+{
+    const char *env(const char *name)
+    {
+        const char *value = std::getenv(name);
+        return value && *value ? value : nullptr;
+    }
+
+    bool readInt(const char *name, long long min, long long max, long long &out)
+    {
+        const char *text = env(name);
+        if (!text)
+            return true;
+        char *end = nullptr;
+        errno = 0;
+        long long value = std::strtoll(text, &end, 10);
+        if (errno || end == text || *end || value < min || value > max)
+        {
+            std::cerr << name << " must be an integer between " << min << " and " << max << ", got \"" << text
+                      << "\"" << std::endl;
+            return false;
+        }
+        out = value;
+        return true;
+    }
+
+    // Reads a keyword setting, case-insensitively, and stores it upper-cased
+    // (lower-cased when `lower`) if it is one of `allowed`.
+    bool readChoice(const char *name, std::initializer_list<const char *> allowed, std::string &out,
+                    bool lower = false)
+    {
+        const char *text = env(name);
+        if (!text)
+            return true;
+        std::string value = text;
+        for (char &c : value)
+            c = lower ? std::tolower(static_cast<unsigned char>(c)) : std::toupper(static_cast<unsigned char>(c));
+        if (std::find(allowed.begin(), allowed.end(), value) != allowed.end())
+        {
+            out = value;
+            return true;
+        }
+        std::cerr << name << " must be one of";
+        for (const char *choice : allowed)
+            std::cerr << ' ' << choice;
+        std::cerr << ", got \"" << text << "\"" << std::endl;
+        return false;
+    }
+}
+
+bool loadConfig(Config &config)
+{
+    if (const char *path = env("HMS_DB_PATH"))
+        config.dbPath = path;
+
+    long long port = config.port, threads = config.threads, warmup = config.warmup;
+    bool ok = readInt("HMS_PORT", 1, 65535, port) && readInt("HMS_THREADS", 0, 1024, threads) &&
+              readChoice("HMS_PROFILE", {"balanced", "durable"}, config.profile, true);
+    if (!ok)
+        return false;
+
+    // The presets differ only in durability: balanced may lose the last few
+    // commits on power loss (never on a crash of the process), durable syncs
+    // the WAL on every commit.
+    if (config.profile == "durable")
+        config.synchronous = "FULL";
+
+    long long busyTimeout = config.busyTimeoutMs, backupStep = config.backupStepMs, spoolMaxMb = config.spoolMaxMb;
+    ok = readChoice("HMS_JOURNAL_MODE", {"WAL", "DELETE", "TRUNCATE", "PERSIST", "MEMORY", "OFF"},
+                    config.journalMode) &&
+         readChoice("HMS_SYNCHRONOUS", {"OFF", "NORMAL", "FULL", "EXTRA"}, config.synchronous) &&
+         readInt("HMS_CACHE_SIZE", -(1ll << 40), 1ll << 40, config.cacheSize) &&
+         readInt("HMS_MMAP_SIZE", 0, 1ll << 46, config.mmapSize) &&
+         readChoice("HMS_TEMP_STORE", {"DEFAULT", "FILE", "MEMORY"}, config.tempStore) &&
+         readInt("HMS_BUSY_TIMEOUT_MS", 0, 600000, busyTimeout) &&
+         readChoice("HMS_INTEGRITY_CHECK", {"off", "quick", "full"}, config.integrityCheck, true) &&
+         readInt("HMS_WARMUP", 0, 1, warmup) && readInt("HMS_BACKUP_STEP_MS", 1, 1000, backupStep) &&
+         readInt("HMS_SPOOL_MAX_MB", 1, 1 << 20, spoolMaxMb);
+    if (!ok)
+        return false;
+
+    long long maxReads = config.maxReads, maxWrites = config.maxWrites, trustForwardedFor = config.trustForwardedFor;
+    long long admissionQueue = config.admissionQueue, admissionWaitMs = config.admissionWaitMs;
+    ok = readInt("HMS_RATE_LIMIT", 0, 1000000, config.rateLimit) &&
+         readInt("HMS_RATE_BURST", 0, 1000000, config.rateBurst) && readInt("HMS_MAX_READS", 0, 100000, maxReads) &&
+         readInt("HMS_MAX_WRITES", 0, 100000, maxWrites) && readInt("HMS_ADMISSION_QUEUE", 0, 100000, admissionQueue) &&
+         readInt("HMS_ADMISSION_WAIT_MS", 0, 10000, admissionWaitMs) &&
+         readInt("HMS_TRUST_FORWARDED_FOR", 0, 1, trustForwardedFor);
+    if (!ok)
+        return false;
+
+    long long appointmentMinutes = config.appointmentMinutes, openingHour = config.openingHour,
+              closingHour = config.closingHour;
+    ok = readInt("HMS_APPOINTMENT_MINUTES", 5, 1440, appointmentMinutes) &&
+         readInt("HMS_OPENING_HOUR", 0, 23, openingHour) && readInt("HMS_CLOSING_HOUR", 1, 24, closingHour);
+    if (!ok)
+        return false;
+    if (closingHour <= openingHour)
+    {
+        std::cerr << "HMS_CLOSING_HOUR must be after HMS_OPENING_HOUR" << std::endl;
+        return false;
+    }
+
+    long long auditSegmentMb = config.auditSegmentMb, auditFlushMs = config.auditFlushMs;
+    ok = readInt("HMS_AUDIT_SEGMENT_MB", 1, 4096, auditSegmentMb) &&
+         readInt("HMS_AUDIT_FLUSH_MS", 1, 10000, auditFlushMs);
+    if (!ok)
+        return false;
+
+    size_t slash = config.dbPath.find_last_of('/');
+    std::string dbDir = slash == std::string::npos ? "" : config.dbPath.substr(0, slash + 1);
+    const char *backupDir = env("HMS_BACKUP_DIR");
+    config.backupDir = backupDir ? backupDir : dbDir + "backups";
+    const char *auditDir = env("HMS_AUDIT_DIR");
+    config.auditDir = auditDir ? auditDir : dbDir + "audit";
+
+    config.port = static_cast<uint16_t>(port);
+    config.threads = static_cast<unsigned>(threads);
+    config.busyTimeoutMs = static_cast<int>(busyTimeout);
+    config.warmup = warmup != 0;
+    config.backupStepMs = static_cast<int>(backupStep);
+    config.spoolMaxMb = static_cast<int>(spoolMaxMb);
+
+    unsigned workers = workerThreads(config);
+    if (!config.rateBurst)
+        config.rateBurst = std::max(1ll, config.rateLimit * 2);
+    // Each worker serves one request at a time, so a read limit at or above
+    // the worker count is never reached; keep a quarter of them (at least one)
+    // out of reach of reads so writes and probes still find a free worker.
+    unsigned readWorkers = std::max(1u, workers - std::max(1u, workers / 4));
+    config.maxReads = maxReads ? static_cast<int>(maxReads) : static_cast<int>(readWorkers);
+    config.maxWrites = maxWrites ? static_cast<int>(maxWrites) : static_cast<int>(std::max(1u, workers / 2));
+    // A queued request holds its worker while it waits, so the queue stays
+    // within the workers the read lane leaves over.
+    config.admissionQueue =
+        admissionQueue ? static_cast<int>(admissionQueue) : static_cast<int>(std::max(1u, workers / 4));
+    config.admissionWaitMs = static_cast<int>(admissionWaitMs);
+    config.trustForwardedFor = trustForwardedFor != 0;
+    config.appointmentMinutes = static_cast<int>(appointmentMinutes);
+    config.openingHour = static_cast<int>(openingHour);
+    config.closingHour = static_cast<int>(closingHour);
+    config.auditSegmentMb = static_cast<int>(auditSegmentMb);
+    config.auditFlushMs = static_cast<int>(auditFlushMs);
+    return true;
+}
+
+std::string connectionPragmas(const Config &config)
+{
+    return "PRAGMA synchronous=" + config.synchronous + "; PRAGMA cache_size=" + std::to_string(config.cacheSize) +
+           "; PRAGMA mmap_size=" + std::to_string(config.mmapSize) + "; PRAGMA temp_store=" + config.tempStore +
+           "; PRAGMA foreign_keys=ON;";
+}
+
+unsigned workerThreads(const Config &config)
+{
+    return config.threads ? config.threads : std::max(1u, std::thread::hardware_concurrency());
+}
+
+void logConfig(const Config &config)
+{
+    std::cout << "Database: " << config.dbPath << "\n"
+              << "Port: " << config.port << ", worker threads: "
+              << (config.threads ? std::to_string(config.threads) : std::string("one per core")) << "\n"
+              << "SQLite profile " << config.profile << ": journal_mode=" << config.journalMode
+              << " synchronous=" << config.synchronous << " cache_size=" << config.cacheSize
+              << " mmap_size=" << config.mmapSize << " temp_store=" << config.tempStore
+              << " busy_timeout=" << config.busyTimeoutMs << "ms\n"
+              << "Startup integrity check: " << config.integrityCheck
+              << ", warm-up: " << (config.warmup ? "on" : "off") << "\n"
+              << "Backups: " << config.backupDir << ", step budget " << config.backupStepMs << "ms\n"
+              << "Spool limit: " << config.spoolMaxMb << " MiB\n"
+              << "Admission: " << config.maxReads << " reads, " << config.maxWrites << " writes at once, "
+              << config.admissionQueue << " of each queued for up to " << config.admissionWaitMs << "ms, rate limit "
+              << (config.rateLimit ? std::to_string(config.rateLimit) + "/s burst " + std::to_string(config.rateBurst)
+                                   : std::string("off"))
+              << (config.trustForwardedFor ? " by X-Forwarded-For" : "") << "\n"
+              << "Appointments: " << config.appointmentMinutes << " minutes by default, slots offered "
+              << config.openingHour << ":00-" << config.closingHour << ":00\n"
+              << "Audit journal: " << config.auditDir << ", " << config.auditSegmentMb << " MiB segments, synced every "
+              << config.auditFlushMs << "ms" << std::endl;
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Server settings, read from HMS_* environment variables at startup. Every
+// variable is optional; the defaults match a local `./crow_sqlite_crud` run.
+//
+//   HMS_DB_PATH          database file (hms.db)
+//   HMS_PORT             listening port (3000)
+//   HMS_THREADS          Crow worker threads, 0 = one per core (0)
+//   HMS_PROFILE          SQLite profile preset: balanced or durable (balanced)
+//   HMS_JOURNAL_MODE     overrides the profile's journal_mode
+//   HMS_SYNCHRONOUS      ... synchronous
+//   HMS_CACHE_SIZE       ... cache_size (pages, or KiB when negative)
+//   HMS_MMAP_SIZE        ... mmap_size in bytes
+//   HMS_TEMP_STORE       ... temp_store
+//   HMS_BUSY_TIMEOUT_MS  ... busy timeout in milliseconds
+//   HMS_INTEGRITY_CHECK  startup check: off, quick or full (quick)
+//   HMS_WARMUP           pre-load hot pages at startup: 0 or 1 (1)
+//   HMS_BACKUP_DIR       where POST /admin/backup writes (backups/ next to
+//                        the database)
+//   HMS_BACKUP_STEP_MS   longest a backup step may hold up writes (5)
+//   HMS_SPOOL_MAX_MB     disk the spooled /users and export bodies in flight
+//                        may use together before requests get 503 (1024)
+//   HMS_RATE_LIMIT       requests per second per client, 0 = unlimited (0)
+//   HMS_RATE_BURST       requests a client may burst above the rate (2 s worth)
+//   HMS_MAX_READS        reads handled at once before shedding with 503
+//                        (0 = all worker threads but a quarter, at least one)
+//   HMS_MAX_WRITES       writes handled or queued at once before shedding
+//                        (0 = half the worker threads, so reads always have
+//                        workers left)
+//   HMS_ADMISSION_QUEUE  requests of each class that may wait for a full
+//                        lane; writes are let in first (0 = a quarter of
+//                        the worker threads, at least one)
+//   HMS_ADMISSION_WAIT_MS  longest a queued request waits before 503, 0 to
+//                        shed at once (25)
+//   HMS_TRUST_FORWARDED_FOR  rate limit by X-Forwarded-For, for use behind
+//                        the nginx proxy: 0 or 1 (0)
+//   HMS_APPOINTMENT_MINUTES  length of an appointment given without a
+//                        duration (30)
+//   HMS_OPENING_HOUR     first hour GET /slots/next offers (9)
+//   HMS_CLOSING_HOUR     hour by which offered slots must end (17)
+//   HMS_AUDIT_DIR        where the audit journal's segments go (audit/ next
+//                        to the database)
+//   HMS_AUDIT_SEGMENT_MB size at which an audit segment is closed (64)
+//   HMS_AUDIT_FLUSH_MS   how often queued audit records are written and
+//                        synced (50)
+struct Config
+{
+    std::string dbPath = "hms.db";
+    uint16_t port = 3000;
+    unsigned threads = 0;
+
+    std::string profile = "balanced";
+    std::string journalMode = "WAL";
+    std::string synchronous = "NORMAL";
+    long long cacheSize = -65536;
+    long long mmapSize = 256ll << 20;
+    std::string tempStore = "MEMORY";
+    int busyTimeoutMs = 5000;
+
+    std::string integrityCheck = "quick";
+    bool warmup = true;
+
+    std::string backupDir;
+    int backupStepMs = 5;
+    int spoolMaxMb = 1024;
+
+    long long rateLimit = 0;
+    long long rateBurst = 0;
+    int maxReads = 0;
+    int maxWrites = 0;
+    int admissionQueue = 0;
+    int admissionWaitMs = 25;
+    bool trustForwardedFor = false;
+
+    int appointmentMinutes = 30;
+    int openingHour = 9;
+    int closingHour = 17;
+
+    std::string auditDir;
+    int auditSegmentMb = 64;
+    int auditFlushMs = 50;
+};
+
+// Fills `config` from the environment. Logs the offending variable and
+// returns false on any invalid value.
+bool loadConfig(Config &config);
+
+// Pragmas that SQLite keeps per connection, to run on every pool connection.
+// Besides the profile this turns on foreign key enforcement, which the
+// users.doctor_id reference relies on.
+std::string connectionPragmas(const Config &config);
+
+// Crow worker threads the server will run with.
+unsigned workerThreads(const Config &config);
+
+// Writes the effective settings to stdout.
+void logConfig(const Config &config);
@@ -0,0 +1,153 @@
+#include "dates.h"
+
+#include <cctype>
+#include <cstdio>
+
+namespace
+{
+    // Reads 1 to `maxDigits` digits at `pos`.
+    bool readNumber(std::string_view text, size_t &pos, int maxDigits, int &value, int &digits)
+    {
+        value = 0;
+        digits = 0;
+        while (pos < text.size() && digits < maxDigits && std::isdigit(static_cast<unsigned char>(text[pos])))
+        {
+            value = value * 10 + (text[pos++] - '0');
+            ++digits;
+        }
+        return digits > 0;
+    }
+
+    bool isSeparator(char c)
+    {
+        return c == '-' || c == '/' || c == '.';
+    }
+
+    int daysInMonth(int year, int month)
+    {
+        static const int days[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+        bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+        return month == 2 && leap ? 29 : days[month - 1];
+    }
+
+    // Days between 1970-01-01 and a proleptic Gregorian date, and back
+    // (Howard Hinnant's civil calendar algorithms).
+    int64_t daysFromCivil(int year, int month, int day)
+    {
+        year -= month <= 2;
+        int64_t era = (year >= 0 ? year : year - 399) / 400;
+        int64_t yearOfEra = year - era * 400;
+        int64_t dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+        int64_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+        return era * 146097 + dayOfEra - 719468;
+    }
+
+    void civilFromDays(int64_t days, int &year, int &month, int &day)
+    {
+        days += 719468;
+        int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+        int64_t dayOfEra = days - era * 146097;
+        int64_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+        int64_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+        int64_t mp = (5 * dayOfYear + 2) / 153;
+        day = static_cast<int>(dayOfYear - (153 * mp + 2) / 5 + 1);
+        month = static_cast<int>(mp < 10 ? mp + 3 : mp - 9);
+        year = static_cast<int>(yearOfEra + era * 400 + (month <= 2));
+    }
+}
+
+bool normalizeDate(std::string_view text, std::string &iso)
+{
+    size_t pos = 0;
+    while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos])))
+        ++pos;
+
+    int first, second, third, digits;
+    if (!readNumber(text, pos, 4, first, digits))
+        return false;
+    bool yearFirst = digits == 4;
+    if (pos >= text.size() || !isSeparator(text[pos]))
+        return false;
+    char separator = text[pos++];
+    if (!readNumber(text, pos, 2, second, digits))
+        return false;
+    if (pos >= text.size() || text[pos] != separator)
+        return false;
+    ++pos;
+    if (!readNumber(text, pos, yearFirst ? 2 : 4, third, digits) || (!yearFirst && digits != 4))
+        return false;
+
+    int year = yearFirst ? first : third;
+    int month = second;
+    int day = yearFirst ? third : first;
+    if (year < 1900 || month < 1 || month > 12 || day < 1 || day > daysInMonth(year, month))
+        return false;
+
+    int hour = -1, minute = 0;
+    if (pos < text.size() && (text[pos] == 'T' || text[pos] == ' '))
+    {
+        size_t timePos = pos + 1;
+        while (timePos < text.size() && text[timePos] == ' ')
+            ++timePos;
+        int h, m;
+        if (readNumber(text, timePos, 2, h, digits) && timePos < text.size() && text[timePos] == ':' &&
+            readNumber(text, ++timePos, 2, m, digits) && digits == 2)
+        {
+            if (timePos < text.size() && text[timePos] == ':')
+            {
+                int s;
+                ++timePos;
+                if (!readNumber(text, timePos, 2, s, digits) || s > 59)
+                    return false;
+            }
+            if (h > 23 || m > 59)
+                return false;
+            hour = h;
+            minute = m;
+            pos = timePos;
+        }
+    }
+
+    while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos])))
+        ++pos;
+    if (pos != text.size())
+        return false;
+
+    char buf[64];
+    if (hour >= 0)
+        std::snprintf(buf, sizeof(buf), "%04d-%02d-%02dT%02d:%02d", year, month, day, hour, minute);
+    else
+        std::snprintf(buf, sizeof(buf), "%04d-%02d-%02d", year, month, day);
+    iso = buf;
+    return true;
+}
+
+bool isoMinutes(std::string_view iso, int64_t &minutes)
+{
+    // Only the fixed layout normalizeDate writes: YYYY-MM-DDTHH:MM.
+    if (iso.size() != 16 || iso[4] != '-' || iso[7] != '-' || iso[10] != 'T' || iso[13] != ':')
+        return false;
+    int fields[5];
+    static const size_t kOffsets[5] = {0, 5, 8, 11, 14};
+    for (int i = 0; i < 5; ++i)
+    {
+        size_t pos = kOffsets[i];
+        int digits;
+        if (!readNumber(iso, pos, i ? 2 : 4, fields[i], digits) || digits != (i ? 2 : 4))
+            return false;
+    }
+    minutes = daysFromCivil(fields[0], fields[1], fields[2]) * 1440 + fields[3] * 60 + fields[4];
+    return true;
+}
+
+std::string isoFromMinutes(int64_t minutes)
+{
+    int64_t days = minutes >= 0 ? minutes / 1440 : (minutes - 1439) / 1440;
+    int minuteOfDay = static_cast<int>(minutes - days * 1440);
+    int year, month, day;
+    civilFromDays(days, year, month, day);
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%04d-%02d-%02dT%02d:%02d", year, month, day, minuteOfDay / 60,
+                  minuteOfDay % 60);
+    return buf;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Normalizes a free-form appointment date to a sortable ISO-8601 string:
+// "YYYY-MM-DD", or "YYYY-MM-DDTHH:MM" when a time is given. Accepts year-first
+// (2025-03-07, 2025/3/7) and day-first (07-03-2025, 7/3/2025, 7.3.2025)
+// dates, optionally followed by " HH:MM", "THH:MM" or "HH:MM:SS" (seconds are
+// dropped). Returns false if `text` is not a valid calendar date.
+bool normalizeDate(std::string_view text, std::string &iso);
+
+// Minutes since 1970-01-01T00:00 for a normalized "YYYY-MM-DDTHH:MM" date, the
+// clock the appointment slot index runs on (local time, no zone). Returns
+// false for a date without a time of day.
+bool isoMinutes(std::string_view iso, int64_t &minutes);
+
+// The "YYYY-MM-DDTHH:MM" form of a minute count from isoMinutes.
+std::string isoFromMinutes(int64_t minutes);
@@ -2,25 +2,17 @@
 set -euo pipefail
 
 DB_DIR="/app/data"
-DB_PATH="$DB_DIR/hospital.db"
+DB_PATH="${HMS_DB_PATH:-$DB_DIR/hospital.db}"
 
-mkdir -p "$DB_DIR"
+mkdir -p "$(dirname "$DB_PATH")"
 
+# The server creates and migrates the schema itself on startup (schema.cpp):
+# users (the patients, with doctor_id), doctors (with patient_count) and the
+# indexes and triggers behind them. Creating tables here would only race
+# with that, so this script just prepares the data directory. A doctors
+# table left by older versions of this script is adopted by the migration.
 if [ ! -f "$DB_PATH" ]; then
-  echo "Initializing database at $DB_PATH"
-  sqlite3 "$DB_PATH" <<'SQL'
-CREATE TABLE IF NOT EXISTS doctors (
-  id INTEGER PRIMARY KEY AUTOINCREMENT,
-  name TEXT NOT NULL,
-  specialty TEXT
-);
-CREATE TABLE IF NOT EXISTS patients (
-  id INTEGER PRIMARY KEY AUTOINCREMENT,
-  name TEXT NOT NULL,
-  ailment TEXT,
-  doctor_id INTEGER DEFAULT 0
-);
-SQL
+  echo "Database will be created at $DB_PATH on first server start"
 else
   echo "Database already exists at $DB_PATH"
 fi
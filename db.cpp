@@ -0,0 +1,102 @@
+#include "db.h"
+
+#include "metrics.h"
+
+#include <algorithm>
+#include <iostream>
+
+DbConnection::~DbConnection()
+{
+    for (auto &entry : stmts_)
+        sqlite3_finalize(entry.second);
+    sqlite3_close(db_);
+}
+
+sqlite3_stmt *DbConnection::prepare(const char *sql)
+{
+    auto it = stmts_.find(sql);
+    if (it != stmts_.end())
+        return it->second;
+
+    sqlite3_stmt *stmt = nullptr;
+    auto started = std::chrono::steady_clock::now();
+    int rc = sqlite3_prepare_v3(db_, sql, -1, SQLITE_PREPARE_PERSISTENT, &stmt, nullptr);
+    recordSqlite(SqliteOp::Prepare, std::chrono::steady_clock::now() - started);
+    if (rc != SQLITE_OK)
+    {
+        std::cerr << "SQL prepare error: " << sqlite3_errmsg(db_) << " in: " << sql << std::endl;
+        sqlite3_finalize(stmt);
+        return nullptr;
+    }
+    stmts_.emplace(sql, stmt);
+    return stmt;
+}
+
+Stmt::~Stmt()
+{
+    if (!stmt_)
+        return;
+    sqlite3_reset(stmt_);
+    sqlite3_clear_bindings(stmt_);
+    // Read and cleared here, so it counts only this borrower's runs.
+    if (sqlite3_stmt_status(stmt_, SQLITE_STMTSTATUS_RUN, 1) > 0)
+        recordSqlite(SqliteOp::Step, std::chrono::steady_clock::now() - started_);
+}
+
+bool DbConnection::exec(const char *sql)
+{
+    char *errMsg = nullptr;
+    if (sqlite3_exec(db_, sql, nullptr, nullptr, &errMsg) != SQLITE_OK)
+    {
+        std::cerr << "SQL error: " << (errMsg ? errMsg : sqlite3_errmsg(db_)) << std::endl;
+        sqlite3_free(errMsg);
+        return false;
+    }
+    return true;
+}
+
+std::unique_ptr<DbConnection> DbPool::open()
+{
+    sqlite3 *db = nullptr;
+    int flags = SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX;
+    if (sqlite3_open_v2(path_.c_str(), &db, flags, nullptr) != SQLITE_OK)
+    {
+        std::cerr << "Can't open database: " << sqlite3_errmsg(db) << std::endl;
+        sqlite3_close(db);
+        return nullptr;
+    }
+    // Connections now contend for the write lock instead of sharing a handle,
+    // so wait for it rather than failing with SQLITE_BUSY.
+    sqlite3_busy_timeout(db, busyTimeoutMs_);
+    auto conn = std::make_unique<DbConnection>(db);
+    if (!connectionSql_.empty() && !conn->exec(connectionSql_.c_str()))
+        return nullptr;
+    return conn;
+}
+
+DbConnection *DbPool::local()
+{
+    struct Cached
+    {
+        const DbPool *pool;
+        std::weak_ptr<DbConnection> owned;  // expires with the pool, even if a new one reuses its address
+        DbConnection *conn;
+    };
+    thread_local std::vector<Cached> cache;
+    for (const Cached &entry : cache)
+    {
+        if (entry.pool == this && !entry.owned.expired())
+            return entry.conn;
+    }
+
+    std::shared_ptr<DbConnection> fresh = open();
+    if (!fresh)
+        return nullptr;
+    cache.erase(std::remove_if(cache.begin(), cache.end(), [](const Cached &entry) { return entry.owned.expired(); }),
+                cache.end());
+    cache.push_back(Cached{this, fresh, fresh.get()});
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    conns_.push_back(std::move(fresh));
+    return cache.back().conn;
+}
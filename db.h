@@ -0,0 +1,101 @@
+#pragma once
+
+#include <sqlite3.h>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// A single SQLite connection together with the statements prepared on it.
+// Each connection belongs to exactly one thread, so it is opened with
+// SQLITE_OPEN_NOMUTEX and its statement cache needs no locking.
+class DbConnection
+{
+public:
+    explicit DbConnection(sqlite3 *db) : db_(db) {}
+    ~DbConnection();
+
+    DbConnection(const DbConnection &) = delete;
+    DbConnection &operator=(const DbConnection &) = delete;
+
+    sqlite3 *handle() const { return db_; }
+
+    // Returns the statement for `sql`, preparing it on first use. The cache is
+    // keyed by the pointer, so `sql` must have static storage (a literal).
+    sqlite3_stmt *prepare(const char *sql);
+
+    // Runs one or more statements that return no rows; logs and returns false on error.
+    bool exec(const char *sql);
+
+private:
+    sqlite3 *db_;
+    std::unordered_map<const char *, sqlite3_stmt *> stmts_;
+};
+
+// Binds `text` without copying it (SQLITE_STATIC), so it must stay valid
+// until the statement is reset. An empty view binds '', never NULL.
+inline int bindView(sqlite3_stmt *stmt, int index, std::string_view text)
+{
+    return sqlite3_bind_text(stmt, index, text.data() ? text.data() : "", static_cast<int>(text.size()), SQLITE_STATIC);
+}
+
+// Borrowed cached statement. Resets it and clears its bindings on scope exit
+// so the next user of the connection starts from a clean statement. If it was
+// run in between, the time since it was borrowed is recorded for /metrics as
+// one execution, however many rows or resets that took.
+class Stmt
+{
+public:
+    Stmt(DbConnection &conn, const char *sql) : stmt_(conn.prepare(sql)), started_(std::chrono::steady_clock::now())
+    {
+    }
+    ~Stmt();
+
+    Stmt(const Stmt &) = delete;
+    Stmt &operator=(const Stmt &) = delete;
+
+    explicit operator bool() const { return stmt_ != nullptr; }
+    operator sqlite3_stmt *() const { return stmt_; }
+
+private:
+    sqlite3_stmt *stmt_;
+    std::chrono::steady_clock::time_point started_;
+};
+
+// Hands every thread its own connection to the same database file, opened the
+// first time that thread asks for one. Crow worker threads therefore never
+// share a handle, and prepared statements live as long as the thread does.
+// The pool owns the connections and closes them when destroyed; a thread's
+// cache holds one entry per pool, so moving between pools reuses each.
+class DbPool
+{
+public:
+    // `connectionSql` runs on every new connection (per-connection pragmas
+    // such as synchronous or cache_size); `busyTimeoutMs` is how long a
+    // connection waits for a lock held by another one.
+    explicit DbPool(std::string path, int busyTimeoutMs = 5000, std::string connectionSql = std::string())
+        : path_(std::move(path)), busyTimeoutMs_(busyTimeoutMs), connectionSql_(std::move(connectionSql))
+    {
+    }
+
+    DbPool(const DbPool &) = delete;
+    DbPool &operator=(const DbPool &) = delete;
+
+    // Connection owned by the calling thread, or nullptr if it cannot be opened.
+    DbConnection *local();
+
+    // Opens an extra connection that the caller owns and uses from one thread.
+    std::unique_ptr<DbConnection> open();
+
+    const std::string &path() const { return path_; }
+
+private:
+    std::string path_;
+    int busyTimeoutMs_;
+    std::string connectionSql_;
+    std::mutex mutex_;
+    std::vector<std::shared_ptr<DbConnection>> conns_;  // threads cache weak references
+};
@@ -0,0 +1,58 @@
+#include "doctors.h"
+
+#include "user_rows.h"
+
+int insertDoctor(DbConnection &conn, Doctor &doctor)
+{
+    Stmt stmt(conn, "INSERT INTO doctors (name, specialty) VALUES (?, ?)");
+    if (!stmt)
+        return SQLITE_ERROR;
+    bindView(stmt, 1, doctor.name);
+    bindView(stmt, 2, doctor.specialty);
+    int rc = sqlite3_step(stmt);
+    if (rc == SQLITE_DONE)
+        doctor.id = sqlite3_last_insert_rowid(conn.handle());
+    return rc;
+}
+
+int updateDoctor(DbConnection &conn, const Doctor &doctor, int &changes)
+{
+    Stmt stmt(conn, "UPDATE doctors SET name=?, specialty=? WHERE id=?");
+    if (!stmt)
+        return SQLITE_ERROR;
+    bindView(stmt, 1, doctor.name);
+    bindView(stmt, 2, doctor.specialty);
+    sqlite3_bind_int64(stmt, 3, doctor.id);
+    int rc = sqlite3_step(stmt);
+    changes = rc == SQLITE_DONE ? sqlite3_changes(conn.handle()) : 0;
+    return rc;
+}
+
+int deleteDoctor(DbConnection &conn, sqlite3_int64 id, int &changes)
+{
+    Stmt stmt(conn, "DELETE FROM doctors WHERE id=?");
+    if (!stmt)
+        return SQLITE_ERROR;
+    sqlite3_bind_int64(stmt, 1, id);
+    int rc = sqlite3_step(stmt);
+    changes = rc == SQLITE_DONE ? sqlite3_changes(conn.handle()) : 0;
+    return rc;
+}
+
+void appendDoctorJson(std::string &out, sqlite3_stmt *stmt)
+{
+    JsonWriter json(out);
+    json.raw('{');
+    json.key("id");
+    json.integer(sqlite3_column_int64(stmt, 0));
+    json.raw(',');
+    json.key("name");
+    appendColumnJson(json, stmt, 1);
+    json.raw(',');
+    json.key("specialty");
+    appendColumnJson(json, stmt, 2);
+    json.raw(',');
+    json.key("patient_count");
+    json.integer(sqlite3_column_int64(stmt, 3));
+    json.raw('}');
+}
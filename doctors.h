@@ -0,0 +1,25 @@
+#pragma once
+
+#include "db.h"
+
+#include <string>
+#include <string_view>
+
+// A doctors row. patient_count is maintained by triggers on users and is
+// never written from here. Text fields are views, as in Patient.
+struct Doctor
+{
+    sqlite3_int64 id = 0;
+    std::string_view name;
+    std::string_view specialty;
+};
+
+// Doctor mutations, run inside writer jobs like the patient ones; each
+// returns the sqlite3_step result. Deleting a doctor unassigns its patients
+// (ON DELETE SET NULL).
+int insertDoctor(DbConnection &conn, Doctor &doctor);
+int updateDoctor(DbConnection &conn, const Doctor &doctor, int &changes);
+int deleteDoctor(DbConnection &conn, sqlite3_int64 id, int &changes);
+
+// JSON object for a row of (id, name, specialty, patient_count).
+void appendDoctorJson(std::string &out, sqlite3_stmt *stmt);
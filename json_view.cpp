@@ -0,0 +1,342 @@
+#include "json_view.h"
+
+#include <charconv>
+#include <cstring>
+#include <system_error>
+
+namespace
+{
+    const int kMaxDepth = 64;
+
+    int hexDigit(char c)
+    {
+        if (c >= '0' && c <= '9')
+            return c - '0';
+        if (c >= 'a' && c <= 'f')
+            return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F')
+            return c - 'A' + 10;
+        return -1;
+    }
+
+    bool readHex4(std::string_view text, size_t pos, unsigned &value)
+    {
+        if (pos + 4 > text.size())
+            return false;
+        value = 0;
+        for (size_t i = pos; i < pos + 4; ++i)
+        {
+            int digit = hexDigit(text[i]);
+            if (digit < 0)
+                return false;
+            value = value << 4 | digit;
+        }
+        return true;
+    }
+
+    char *appendUtf8(char *out, unsigned cp)
+    {
+        if (cp < 0x80)
+            *out++ = static_cast<char>(cp);
+        else if (cp < 0x800)
+        {
+            *out++ = static_cast<char>(0xc0 | cp >> 6);
+            *out++ = static_cast<char>(0x80 | (cp & 0x3f));
+        }
+        else if (cp < 0x10000)
+        {
+            *out++ = static_cast<char>(0xe0 | cp >> 12);
+            *out++ = static_cast<char>(0x80 | (cp >> 6 & 0x3f));
+            *out++ = static_cast<char>(0x80 | (cp & 0x3f));
+        }
+        else
+        {
+            *out++ = static_cast<char>(0xf0 | cp >> 18);
+            *out++ = static_cast<char>(0x80 | (cp >> 12 & 0x3f));
+            *out++ = static_cast<char>(0x80 | (cp >> 6 & 0x3f));
+            *out++ = static_cast<char>(0x80 | (cp & 0x3f));
+        }
+        return out;
+    }
+}
+
+JsonView::JsonView(RequestArena &arena) : arena_(arena), nodes_(arena.resource()) {}
+
+bool JsonView::parse(std::string_view text)
+{
+    nodes_.clear();
+    // Room for a single-record body, so the tree is laid out once.
+    nodes_.reserve(32);
+    input_ = text;
+    pos_ = 0;
+    bool ok = parseValue(0);
+    skipSpace();
+    if (!ok || pos_ != input_.size())
+    {
+        nodes_.clear();
+        return false;
+    }
+    return true;
+}
+
+JsonView::Value JsonView::root() const
+{
+    return nodes_.empty() ? Value() : Value(nodes_.data());
+}
+
+void JsonView::skipSpace()
+{
+    while (pos_ < input_.size() &&
+           (input_[pos_] == ' ' || input_[pos_] == '\t' || input_[pos_] == '\n' || input_[pos_] == '\r'))
+        ++pos_;
+}
+
+bool JsonView::parseValue(int depth)
+{
+    if (depth > kMaxDepth)
+        return false;
+    skipSpace();
+    if (pos_ >= input_.size())
+        return false;
+
+    size_t index = nodes_.size();
+    nodes_.push_back(Node{Type::Missing, 1, {}});
+    char c = input_[pos_];
+
+    if (c == '{' || c == '[')
+    {
+        bool object = c == '{';
+        nodes_[index].type = object ? Type::Object : Type::List;
+        ++pos_;
+        skipSpace();
+        char close = object ? '}' : ']';
+        if (pos_ < input_.size() && input_[pos_] == close)
+            ++pos_;
+        else
+        {
+            for (;;)
+            {
+                if (object)
+                {
+                    // Keys are nodes too, so a lookup can walk members in order.
+                    skipSpace();
+                    std::string_view key;
+                    if (pos_ >= input_.size() || input_[pos_] != '"' || !parseString(key))
+                        return false;
+                    nodes_.push_back(Node{Type::String, 1, key});
+                    skipSpace();
+                    if (pos_ >= input_.size() || input_[pos_++] != ':')
+                        return false;
+                }
+                if (!parseValue(depth + 1))
+                    return false;
+                skipSpace();
+                if (pos_ >= input_.size())
+                    return false;
+                char next = input_[pos_++];
+                if (next == close)
+                    break;
+                if (next != ',')
+                    return false;
+            }
+        }
+        nodes_[index].span = static_cast<uint32_t>(nodes_.size() - index);
+        return true;
+    }
+
+    if (c == '"')
+    {
+        nodes_[index].type = Type::String;
+        return parseString(nodes_[index].text);
+    }
+
+    static const struct
+    {
+        const char *word;
+        Type type;
+    } kLiterals[] = {{"null", Type::Null}, {"true", Type::True}, {"false", Type::False}};
+    for (const auto &literal : kLiterals)
+    {
+        size_t len = std::strlen(literal.word);
+        if (input_.compare(pos_, len, literal.word) == 0)
+        {
+            nodes_[index].type = literal.type;
+            pos_ += len;
+            return true;
+        }
+    }
+
+    // Number: -?digits[.digits][e[+-]digits], kept as its literal text.
+    size_t start = pos_;
+    if (pos_ < input_.size() && input_[pos_] == '-')
+        ++pos_;
+    size_t digits = pos_;
+    auto skipDigits = [this] {
+        while (pos_ < input_.size() && input_[pos_] >= '0' && input_[pos_] <= '9')
+            ++pos_;
+    };
+    skipDigits();
+    if (pos_ == digits)
+        return false;
+    if (pos_ < input_.size() && input_[pos_] == '.')
+    {
+        ++pos_;
+        size_t fraction = pos_;
+        skipDigits();
+        if (pos_ == fraction)
+            return false;
+    }
+    if (pos_ < input_.size() && (input_[pos_] == 'e' || input_[pos_] == 'E'))
+    {
+        ++pos_;
+        if (pos_ < input_.size() && (input_[pos_] == '+' || input_[pos_] == '-'))
+            ++pos_;
+        size_t exponent = pos_;
+        skipDigits();
+        if (pos_ == exponent)
+            return false;
+    }
+    nodes_[index].type = Type::Number;
+    nodes_[index].text = input_.substr(start, pos_ - start);
+    return true;
+}
+
+bool JsonView::parseString(std::string_view &out)
+{
+    // At the opening quote. Find the closing one, noting whether anything
+    // needs unescaping; most request strings do not and stay views.
+    size_t start = ++pos_;
+    bool escaped = false;
+    while (pos_ < input_.size() && input_[pos_] != '"')
+    {
+        unsigned char c = static_cast<unsigned char>(input_[pos_]);
+        if (c < 0x20)
+            return false;
+        if (c == '\\')
+        {
+            escaped = true;
+            ++pos_;
+        }
+        ++pos_;
+    }
+    if (pos_ >= input_.size())
+        return false;
+    size_t end = pos_++;
+    if (!escaped)
+    {
+        out = input_.substr(start, end - start);
+        return true;
+    }
+
+    // Unescaped text is never longer than its escaped form.
+    char *buffer = arena_.allocate(end - start);
+    char *write = buffer;
+    for (size_t i = start; i < end; ++i)
+    {
+        char c = input_[i];
+        if (c != '\\')
+        {
+            *write++ = c;
+            continue;
+        }
+        switch (input_[++i])
+        {
+        case '"': *write++ = '"'; break;
+        case '\\': *write++ = '\\'; break;
+        case '/': *write++ = '/'; break;
+        case 'b': *write++ = '\b'; break;
+        case 'f': *write++ = '\f'; break;
+        case 'n': *write++ = '\n'; break;
+        case 'r': *write++ = '\r'; break;
+        case 't': *write++ = '\t'; break;
+        case 'u':
+        {
+            unsigned cp;
+            if (!readHex4(input_, i + 1, cp))
+                return false;
+            i += 4;
+            if (cp >= 0xd800 && cp < 0xdc00)
+            {
+                unsigned low;
+                if (i + 2 >= end || input_[i + 1] != '\\' || input_[i + 2] != 'u' || !readHex4(input_, i + 3, low) ||
+                    low < 0xdc00 || low >= 0xe000)
+                    return false;
+                cp = 0x10000 + ((cp - 0xd800) << 10) + (low - 0xdc00);
+                i += 6;
+            }
+            else if (cp >= 0xdc00 && cp < 0xe000)
+                return false;
+            write = appendUtf8(write, cp);
+            break;
+        }
+        default:
+            return false;
+        }
+    }
+    out = std::string_view(buffer, write - buffer);
+    return true;
+}
+
+JsonView::Value JsonView::Value::operator[](std::string_view key) const
+{
+    if (t() != Type::Object)
+        return Value();
+    const Node *end = node_ + node_->span;
+    for (const Node *member = node_ + 1; member < end;)
+    {
+        const Node *value = member + 1;
+        if (member->text == key)
+            return Value(value);
+        member = value + value->span;
+    }
+    return Value();
+}
+
+int64_t JsonView::Value::i() const
+{
+    if (t() != Type::Number)
+        return 0;
+    int64_t value = 0;
+    std::from_chars(node_->text.data(), node_->text.data() + node_->text.size(), value);
+    return value;
+}
+
+bool JsonView::Value::integer(int64_t &out) const
+{
+    if (t() != Type::Number)
+        return false;
+    const char *begin = node_->text.data(), *end = begin + node_->text.size();
+    int64_t value = 0;
+    auto result = std::from_chars(begin, end, value);
+    if (result.ec != std::errc() || result.ptr != end)
+        return false;
+    out = value;
+    return true;
+}
+
+size_t JsonView::Value::size() const
+{
+    if (t() != Type::List && t() != Type::Object)
+        return 0;
+    size_t count = 0;
+    const Node *end = node_ + node_->span;
+    for (const Node *child = node_ + 1; child < end; child += child->span)
+        ++count;
+    return t() == Type::Object ? count / 2 : count;
+}
+
+JsonView::Value::Iterator &JsonView::Value::Iterator::operator++()
+{
+    node_ += node_->span;
+    return *this;
+}
+
+JsonView::Value::Iterator JsonView::Value::begin() const
+{
+    return Iterator(t() == Type::List ? node_ + 1 : nullptr);
+}
+
+JsonView::Value::Iterator JsonView::Value::end() const
+{
+    return Iterator(t() == Type::List ? node_ + node_->span : nullptr);
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "arena.h"
+
+#include <cstdint>
+#include <memory_resource>
+#include <string_view>
+#include <vector>
+
+// Read-only JSON parser for request bodies. It takes no copies: the parse
+// tree is a flat array of nodes allocated from a RequestArena, and a string
+// value is a view straight into the body unless it contains escapes, in
+// which case it is unescaped once into the arena. Everything it returns
+// therefore lives as long as both the body and the arena scope, which for a
+// handler is until it returns, long enough to bind with SQLITE_STATIC.
+//
+// The accessors mirror the crow::json::rvalue calls the handlers used
+// (t(), has(), operator[], s(), i(), iteration over lists), so a missing key
+// or a wrong type reads as an empty value instead of throwing.
+class JsonView
+{
+public:
+    enum class Type : uint8_t
+    {
+        Missing,  // absent key, out-of-range index, or a failed parse
+        Null,
+        False,
+        True,
+        Number,
+        String,
+        List,
+        Object,
+    };
+
+    class Value;
+
+    explicit JsonView(RequestArena &arena);
+
+    // Parses `text`, which must hold exactly one JSON value. Returns false on
+    // malformed input or nesting deeper than 64 levels.
+    bool parse(std::string_view text);
+
+    Value root() const;
+
+private:
+    struct Node
+    {
+        Type type;
+        uint32_t span;          // nodes in this subtree, itself included
+        std::string_view text;  // string contents, or the number's literal
+    };
+
+    bool parseValue(int depth);
+    bool parseString(std::string_view &out);
+    void skipSpace();
+
+    RequestArena &arena_;
+    std::pmr::vector<Node> nodes_;
+    std::string_view input_;
+    size_t pos_ = 0;
+};
+
+class JsonView::Value
+{
+public:
+    Value() = default;
+
+    Type t() const { return node_ ? node_->type : Type::Missing; }
+    explicit operator bool() const { return t() != Type::Missing; }
+
+    bool has(std::string_view key) const { return bool((*this)[key]); }
+    Value operator[](std::string_view key) const;
+
+    // String contents, or empty for non-strings; check t() first where a
+    // missing or wrong-typed field must be refused.
+    std::string_view s() const { return t() == Type::String ? node_->text : std::string_view(); }
+
+    // Integer value of a number (any fraction or exponent is ignored), 0 for
+    // non-numbers.
+    int64_t i() const;
+
+    // Sets `out` and returns true only for a number written as an integer
+    // that fits in int64; a fraction, an exponent or an overflow is false.
+    bool integer(int64_t &out) const;
+
+    // Elements of a list or members of an object.
+    size_t size() const;
+
+    class Iterator
+    {
+    public:
+        Iterator(const Node *node) : node_(node) {}
+        Value operator*() const { return Value(node_); }
+        Iterator &operator++();
+        bool operator!=(const Iterator &other) const { return node_ != other.node_; }
+
+    private:
+        const Node *node_;
+    };
+
+    // Iterates the elements of a list; empty for anything else.
+    Iterator begin() const;
+    Iterator end() const;
+
+private:
+    friend class JsonView;
+    explicit Value(const Node *node) : node_(node) {}
+
+    const Node *node_ = nullptr;
+};
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+// Appends JSON text straight into a caller-owned buffer. Nothing is built up
+// as a tree: strings are escaped directly from the source memory (for example
+// a sqlite3_column_text result) and integers are formatted with to_chars, so
+// the only allocations are the buffer's own growth, which a reused buffer
+// stops paying after the first few rows.
+class JsonWriter
+{
+public:
+    explicit JsonWriter(std::string &out) : out_(out) {}
+
+    void raw(char c) { out_.push_back(c); }
+    void raw(const char *text, size_t len) { out_.append(text, len); }
+
+    // Writes `"key":`; the key must not need escaping.
+    void key(const char *name)
+    {
+        out_.push_back('"');
+        out_.append(name);
+        out_.append("\":", 2);
+    }
+
+    void null() { out_.append("null", 4); }
+
+    void integer(int64_t value)
+    {
+        char digits[20];
+        auto end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+        out_.append(digits, end - digits);
+    }
+
+    // Writes a quoted, escaped string; `text` may be null, which writes null.
+    void string(const char *text, size_t len)
+    {
+        if (!text)
+        {
+            null();
+            return;
+        }
+        out_.push_back('"');
+        const char *run = text;
+        const char *end = text + len;
+        for (const char *p = text; p != end; ++p)
+        {
+            unsigned char c = static_cast<unsigned char>(*p);
+            if (c >= 0x20 && c != '"' && c != '\\')
+                continue;
+            out_.append(run, p - run);
+            run = p + 1;
+            switch (c)
+            {
+            case '"': out_.append("\\\"", 2); break;
+            case '\\': out_.append("\\\\", 2); break;
+            case '\n': out_.append("\\n", 2); break;
+            case '\r': out_.append("\\r", 2); break;
+            case '\t': out_.append("\\t", 2); break;
+            case '\b': out_.append("\\b", 2); break;
+            case '\f': out_.append("\\f", 2); break;
+            default:
+            {
+                static const char hex[] = "0123456789abcdef";
+                char escaped[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xf]};
+                out_.append(escaped, 6);
+            }
+            }
+        }
+        out_.append(run, end - run);
+        out_.push_back('"');
+    }
+
+    void string(std::string_view text) { string(text.data() ? text.data() : "", text.size()); }
+
+private:
+    std::string &out_;
+};
@@ -1,622 +1,1613 @@
 #include "crow.h"     // including crow frameword
+#include "admission.h"
+#include "admission_middleware.h"
+#include "alloc_count.h"
+#include "arena.h"
+#include "audit_journal.h"
+#include "backup.h"
+#include "bulk_import.h"
+#include "change_feed.h"
+#include "compress.h"
+#include "config.h"
+#include "dates.h"
+#include "db.h"
+#include "doctors.h"
+#include "json_view.h"
+#include "metrics.h"
+#include "metrics_middleware.h"
+#include "pages.h"
+#include "patient_cache.h"
+#include "patient_stats.h"
+#include "patients.h"
+#include "schema.h"
+#include "session_middleware.h"
+#include "session_store.h"
+#include "slot_index.h"
+#include "spool.h"
+#include "startup.h"
+#include "static_page.h"
+#include "user_format.h"
+#include "user_rows.h"
+#include "writer.h"
 #include <sqlite3.h>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
 #include <iostream>
-#include <sstream>
+#include <vector>
 
-int main()
+// Page size for /users when after_id is given without a limit, and the cap
+// on any explicit limit unless the body is spooled (stream=1).
+static const sqlite3_int64 kDefaultPageSize = 100;
+static const sqlite3_int64 kMaxPageSize = 1000;
+
+// Serialized rows are handed to the spool once this many bytes accumulate.
+static const size_t kSpoolFlushBytes = 32 * 1024;
+
+// Rows per writer job in POST /users/bulk, and how many rejected rows are
+// described individually in its reply.
+static const size_t kBulkChunkRows = 10000;
+static const size_t kBulkMaxErrors = 100;
+// A chunk's audit records are queued from the writer thread's commit hook,
+// which must not wait for the journal's disk.
+static_assert(AuditJournal::kDefaultCapacity >= kBulkChunkRows, "a /users/bulk chunk must fit in the audit ring");
+
+// Most operations accepted in one POST /batch.
+static const size_t kMaxBatchOps = 1000;
+
+// Default and maximum number of rows from /appointments.
+static const sqlite3_int64 kDefaultAppointments = 1000;
+static const sqlite3_int64 kMaxAppointments = 10000;
+
+// Default and maximum number of results from /users/search.
+static const sqlite3_int64 kDefaultSearchResults = 20;
+static const sqlite3_int64 kMaxSearchResults = 100;
+
+// Parses a whole decimal query parameter; rejects empty or trailing input.
+static bool parseInt64(const char *text, sqlite3_int64 &out)
+{
+    char *end = nullptr;
+    errno = 0;
+    long long value = std::strtoll(text, &end, 10);
+    if (errno || end == text || *end)
+        return false;
+    out = value;
+    return true;
+}
+
+
+// One operation of a POST /batch request.
+struct BatchOp
 {
-    crow::SimpleApp app;
-      bool isLoggedIn = false;
-    // Initialize SQLite database
-    sqlite3 *db;
-    if (sqlite3_open("hms.db", &db))
+    enum class Kind
     {
-        std::cerr << "Can't open database: " << sqlite3_errmsg(db) << std::endl;
-        return 1;
+        Add,
+        Edit,
+        Delete
+    };
+
+    Kind kind = Kind::Add;
+    Patient patient;
+    int changes = 0;
+};
+
+static const char *batchOpName(BatchOp::Kind kind)
+{
+    return kind == BatchOp::Kind::Add ? "add" : kind == BatchOp::Kind::Edit ? "edit" : "delete";
+}
+
+static const char kSlotTaken[] = "appointment slot already booked";
+
+// Request field readers. JsonView reads a missing or wrong-typed member as
+// empty, so each of these fails instead and the handler answers 400.
+
+// The string member `key` of `body`; false if it is missing or not a string.
+static bool readString(JsonView::Value body, const char *key, std::string_view &out)
+{
+    JsonView::Value value = body[key];
+    if (value.t() != JsonView::Type::String)
+        return false;
+    out = value.s();
+    return true;
+}
+
+// The integer member `key` of `body`; false if it is missing, not a number,
+// has a fraction or exponent, or does not fit in 64 bits.
+static bool readInteger(JsonView::Value body, const char *key, sqlite3_int64 &out)
+{
+    int64_t value;
+    if (!body[key].integer(value))
+        return false;
+    out = value;
+    return true;
+}
+
+// As readString and readInteger for optional members: an absent or null
+// member leaves `out` as it is.
+static bool readOptionalString(JsonView::Value body, const char *key, std::string_view &out)
+{
+    JsonView::Value value = body[key];
+    return !value || value.t() == JsonView::Type::Null || readString(body, key, out);
+}
+
+static bool readOptionalInteger(JsonView::Value body, const char *key, sqlite3_int64 &out)
+{
+    JsonView::Value value = body[key];
+    return !value || value.t() == JsonView::Type::Null || readInteger(body, key, out);
+}
+
+// name, phone, disease and date, all required strings; also normalizes the date.
+static bool readPatientFields(JsonView::Value body, Patient &patient)
+{
+    if (!readString(body, "name", patient.name) || !readString(body, "phone", patient.phone) ||
+        !readString(body, "disease", patient.disease) || !readString(body, "date", patient.date))
+        return false;
+    normalizeDate(patient.date, patient.dateIso);
+    return true;
+}
+
+// Reads the optional "duration" of an appointment, in minutes. Returns false
+// if it is present but not between 1 and a day.
+static bool readDuration(JsonView::Value body, Patient &patient)
+{
+    JsonView::Value duration = body["duration"];
+    if (!duration || duration.t() == JsonView::Type::Null)
+        return true;
+    int64_t minutes;
+    if (!duration.integer(minutes) || minutes < 1 || minutes > 24 * 60)
+        return false;
+    patient.duration = static_cast<int>(minutes);
+    return true;
+}
+
+// The doctor whose calendar holds a patient's appointment: the slot index
+// knows it for booked patients, the users row for the rest.
+static sqlite3_int64 patientDoctor(DbConnection &conn, const SlotIndex &slots, sqlite3_int64 id)
+{
+    sqlite3_int64 doctorId = 0;
+    if (slots.doctorOf(id, doctorId))
+        return doctorId;
+    Stmt stmt(conn, "SELECT doctor_id FROM users WHERE id=?");
+    if (!stmt)
+        return 0;
+    sqlite3_bind_int64(stmt, 1, id);
+    if (sqlite3_step(stmt) == SQLITE_ROW)
+        doctorId = sqlite3_column_int64(stmt, 0);
+    return doctorId;
+}
+
+// insertPatient and updatePatient for writer jobs that keep the slot index
+// in step. If the appointment overlaps another booking of the same doctor
+// nothing is written, `taken` is set and SQLITE_CONSTRAINT returned.
+static int insertBooked(DbConnection &conn, SlotIndex &slots, Patient &patient, bool &taken)
+{
+    if (!slots.available(patient, patient.doctorId))
+    {
+        taken = true;
+        return SQLITE_CONSTRAINT;
     }
+    int rc = insertPatient(conn, patient);
+    if (rc == SQLITE_DONE)
+        slots.book(patient, patient.doctorId);
+    return rc;
+}
 
-    // Create table if not exists
-    const char *create_table_sql =
-        "CREATE TABLE IF NOT EXISTS users ("
-        "id INTEGER PRIMARY KEY AUTOINCREMENT, "
-        "name TEXT NOT NULL, "
-        "phone TEXT NOT NULL, "
-        "disease TEXT NOT NULL, "
-        "date TEXT NOT NULL);";
-
-    const char *create_accounts_table =
-       "CREATE TABLE IF NOT EXISTS accounts ("
-       "id INTEGER PRIMARY KEY AUTOINCREMENT, "
-       "username TEXT NOT NULL UNIQUE, "
-       "password TEXT NOT NULL);";
-
-
-      char *errMsg = nullptr;
-      if (sqlite3_exec(db, create_accounts_table, nullptr, nullptr, &errMsg) != SQLITE_OK)
-      {
-          std::cerr << "SQL error: " << errMsg << std::endl;
-         sqlite3_free(errMsg);
-      }
-
-      // Insert default admin only if table empty
-      sqlite3_stmt *checkStmt;
-      sqlite3_prepare_v2(db, "SELECT COUNT(*) FROM accounts;", -1, &checkStmt, nullptr);
-      sqlite3_step(checkStmt);
-      int count = sqlite3_column_int(checkStmt, 0);
-     sqlite3_finalize(checkStmt);
-
-     if (count == 0)
+static int updateBooked(DbConnection &conn, SlotIndex &slots, const Patient &patient, int &changes, bool &taken)
+{
+    sqlite3_int64 doctorId = patientDoctor(conn, slots, patient.id);
+    if (!slots.available(patient, doctorId))
     {
-       sqlite3_exec(db, "INSERT INTO accounts (username, password) VALUES ('admin', '1234');", nullptr, nullptr, nullptr);
+        taken = true;
+        return SQLITE_CONSTRAINT;
     }
+    int rc = updatePatient(conn, patient, changes);
+    if (rc == SQLITE_DONE && changes)
+        slots.book(patient, doctorId);
+    return rc;
+}
+
+// Fills `op` from one element of the /batch array. Returns nullptr, or why
+// the element was rejected.
+static const char *parseBatchOp(JsonView::Value item, BatchOp &op)
+{
+    if (item.t() != JsonView::Type::Object || item["op"].t() != JsonView::Type::String)
+        return "expected an object with an op";
+    std::string_view name = item["op"].s();
+    if (name == "add")
+        op.kind = BatchOp::Kind::Add;
+    else if (name == "edit")
+        op.kind = BatchOp::Kind::Edit;
+    else if (name == "delete")
+        op.kind = BatchOp::Kind::Delete;
+    else
+        return "op must be add, edit or delete";
+
+    if (op.kind != BatchOp::Kind::Add && !readInteger(item, "id", op.patient.id))
+        return "id is required";
+    if (op.kind == BatchOp::Kind::Delete)
+        return nullptr;
+
+    if (!readPatientFields(item, op.patient))
+        return "name, phone, disease and date are required";
+    if (!readDuration(item, op.patient))
+        return "duration must be between 1 and 1440 minutes";
+    if (op.kind == BatchOp::Kind::Add && !readOptionalInteger(item, "doctor_id", op.patient.doctorId))
+        return "doctor_id must be a number";
+    return nullptr;
+}
 
+// Letters and digits, plus any byte of a multi-byte UTF-8 character.
+static bool isWordByte(char c)
+{
+    unsigned char u = static_cast<unsigned char>(c);
+    return u >= 0x80 || std::isalnum(u);
+}
 
-    if (sqlite3_exec(db, create_table_sql, nullptr, nullptr, &errMsg) != SQLITE_OK)
+// Turns free text into an FTS5 query that prefix-matches every word, e.g.
+// `jo diab` becomes `"jo"* "diab"*`. Punctuation separates words and never
+// reaches FTS5, so user input cannot form query syntax. Empty if no words.
+static std::string ftsPrefixQuery(const std::string &text)
+{
+    std::string query;
+    size_t i = 0;
+    while (i < text.size())
     {
-       std::cerr << "SQL error: " << errMsg << std::endl;
-        sqlite3_free(errMsg);
+        while (i < text.size() && !isWordByte(text[i]))
+            ++i;
+        size_t start = i;
+        while (i < text.size() && isWordByte(text[i]))
+            ++i;
+        if (i == start)
+            break;
+        if (!query.empty())
+            query.push_back(' ');
+        query.push_back('"');
+        query.append(text, start, i - start);
+        query.append("\"*");
     }
+    return query;
+}
+
+// Sets Content-Encoding for a body sent with `coding`, and Vary, since the
+// list endpoints pick both format and coding from the request headers.
+static void setListEncoding(crow::response &res, ContentCoding coding)
+{
+    if (coding != ContentCoding::Identity)
+        res.set_header("Content-Encoding", codingName(coding));
+    res.set_header("Vary", "Accept, Accept-Encoding");
+}
+
+// Answer when the spool directory is at its size limit: the client should
+// come back once the bodies in flight have been sent.
+static crow::response spoolFull()
+{
+    crow::response res(503, "Too many exports in progress");
+    res.set_header("Retry-After", "10");
+    return res;
+}
+
+// Runs `stmt` to completion, appending each row in `layout` into a reused
+// buffer that is flushed (and compressed with `coding`) to a spool file, and
+// returns a response that sends the file once it is complete. `coding` is
+// updated to the one the body was actually sent with.
+static crow::response spoolRows(sqlite3_stmt *stmt, const UserListLayout &layout, ContentCoding &coding)
+{
+    Spool spool;
+    if (!spool.open(coding))
+        return spool.full() ? spoolFull() : crow::response(500, "Spool error");
+
+    // One row buffer reused for the whole result; its capacity settles after
+    // the first rows and it is flushed in large pieces.
+    std::string rows;
+    rows.reserve(kSpoolFlushBytes + 1024);
+    rows.append(layout.open);
+    bool first = true;
+    while (sqlite3_step(stmt) == SQLITE_ROW)
+    {
+        if (!first)
+            rows.append(layout.separator);
+        first = false;
+        layout.appendRow(rows, stmt);
+        if (rows.size() >= kSpoolFlushBytes)
+        {
+            spool.write(rows);
+            rows.clear();
+        }
+    }
+    rows.append(layout.close);
+    spool.write(rows);
+    if (!spool.finish())
+        return spool.full() ? spoolFull() : crow::response(500, "Spool error");
+
+    crow::response res;
+    res.set_static_file_info_unsafe(spool.path());
+    res.set_header("Content-Type", layout.contentType);
+    coding = spool.coding();
+    setListEncoding(res, coding);
+    return res;
+}
+
+// spoolRows for users rows in `format`. A MessagePack array starts with its
+// length, so for that format `countStmt` is stepped first, in the same read
+// transaction as `stmt` so that both see the same rows.
+static crow::response spoolUsers(DbConnection &conn, sqlite3_stmt *stmt, sqlite3_stmt *countStmt, UserFormat format,
+                                 ContentCoding &coding)
+{
+    if (!layoutNeedsCount(format))
+        return spoolRows(stmt, userListLayout(format), coding);
+
+    if (!conn.exec("BEGIN"))
+        return crow::response(500, "Database error");
+    crow::response res(500, "Database error");
+    if (sqlite3_step(countStmt) == SQLITE_ROW)
+        res = spoolRows(stmt, userListLayout(format, sqlite3_column_int64(countStmt, 0)), coding);
+    sqlite3_reset(countStmt);
+    sqlite3_reset(stmt);
+    conn.exec("COMMIT");
+    return res;
+}
+
+// Steps `stmt` (users rows) into `body` in `format`; returns the row count and
+// leaves the last id in `lastId`.
+static sqlite3_int64 appendUserList(std::string &body, sqlite3_stmt *stmt, UserFormat format, sqlite3_int64 &lastId)
+{
+    UserListLayout layout = userListLayout(format);
+    size_t start = body.size();
+    if (!layoutNeedsCount(format))
+        body.append(layout.open);
+    sqlite3_int64 rowCount = 0;
+    while (sqlite3_step(stmt) == SQLITE_ROW)
+    {
+        if (rowCount++)
+            body.append(layout.separator);
+        lastId = sqlite3_column_int64(stmt, 0);
+        layout.appendRow(body, stmt);
+    }
+    body.append(layout.close);
+    if (layoutNeedsCount(format))
+        body.insert(start, userListLayout(format, rowCount).open);
+    return rowCount;
+}
+
+// ETag of one encoding of the /users list: the cache version's tag with the
+// format and content coding appended, e.g. "<epoch>-42-cbor-gzip". Plain
+// JSON keeps the bare version tag.
+static std::string usersEtag(const std::string &versionTag, UserFormat format, ContentCoding coding)
+{
+    static const char *const suffixes[] = {"", "-ndjson", "-csv", "-cbor", "-msgpack"};
+    std::string tag = versionTag.substr(0, versionTag.size() - 1) + suffixes[(int)format];
+    if (coding != ContentCoding::Identity)
+        tag += std::string("-") + codingName(coding);
+    return tag + '"';
+}
+
+// True if If-None-Match names the current version in `format`, under any
+// coding: the content is the same whichever one the client cached.
+static bool usersEtagMatches(const std::string &ifNoneMatch, const std::string &versionTag, UserFormat format)
+{
+    for (ContentCoding coding : {ContentCoding::Identity, ContentCoding::Gzip, ContentCoding::Zstd})
+        if (ifNoneMatch.find(usersEtag(versionTag, format, coding)) != std::string::npos)
+            return true;
+    return false;
+}
+
+// JSON body for the /admin/backup routes.
+static crow::response backupResponse(int code, const BackupProgress &progress)
+{
+    std::string body;
+    JsonWriter json(body);
+    json.raw("{\"state\":", 9);
+    json.string(progress.state.data(), progress.state.size());
+    json.raw(",\"path\":", 8);
+    json.string(progress.path.data(), progress.path.size());
+    json.raw(",\"pages_total\":", 15);
+    json.integer(progress.pagesTotal);
+    json.raw(",\"pages_remaining\":", 19);
+    json.integer(progress.pagesRemaining);
+    json.raw(",\"pages_per_step\":", 18);
+    json.integer(progress.pagesPerStep);
+    json.raw(",\"elapsed_ms\":", 14);
+    json.integer(progress.elapsedMs);
+    if (!progress.error.empty())
+    {
+        json.raw(",\"error\":", 9);
+        json.string(progress.error.data(), progress.error.size());
+    }
+    json.raw('}');
+
+    crow::response res(code, std::move(body));
+    res.set_header("Content-Type", "application/json");
+    return res;
+}
+
+int main()
+{
+    Config config;
+    if (!loadConfig(config))
+        return 1;
+    logConfig(config);
+    setSpoolLimit(static_cast<uint64_t>(config.spoolMaxMb) << 20);
+
+    // Startup phases are timed so a slow start on a large database shows
+    // where the time went.
+    auto initStarted = std::chrono::steady_clock::now();
+    auto phaseStarted = initStarted;
+    auto logPhase = [&phaseStarted](const char *phase) {
+        auto now = std::chrono::steady_clock::now();
+        std::cout << phase << ": "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(now - phaseStarted).count() << " ms"
+                  << std::endl;
+        phaseStarted = now;
+    };
+
+    crow::App<MetricsMiddleware, AdmissionMiddleware, SessionMiddleware> app;
+    // Initialize SQLite database. Every Crow worker thread gets its own
+    // connection from the pool the first time it handles a request, with the
+    // profile's per-connection pragmas applied.
+    DbPool pool(config.dbPath, config.busyTimeoutMs, connectionPragmas(config));
+    DbConnection *db = pool.local();
+    if (!db)
+        return 1;
+
+    // The journal mode is stored in the database file rather than per
+    // connection. WAL lets /users readers keep going while the writer commits.
+    if (!applyJournalMode(*db, config.journalMode))
+        std::cerr << "Continuing with the database's current journal mode" << std::endl;
+    logPhase("Open database");
+
+    if (!checkIntegrity(*db, config.integrityCheck))
+        return 1;
+    logPhase("Integrity check");
+
+    // Create or upgrade the tables
+    if (!migrateSchema(*db))
+        return 1;
+    logPhase("Schema migration");
+
+    if (config.warmup)
+    {
+        warmUp(*db);
+        logPhase("Warm-up");
+    }
+
+    // Mirror of the users table that serves GET /users; kept current by the
+    // mutation handlers' commit hooks below.
+    PatientCache cache;
+    if (!cache.load(*db))
+        return 1;
+    logPhase("Load patient cache");
+
+    // Appointment bookings per doctor and day for conflict checks and
+    // GET /slots/next; writer jobs update it and roll it back with their
+    // transactions.
+    SlotIndex slots(config.appointmentMinutes);
+    if (!slots.load(*db))
+        return 1;
+    std::cout << "Appointment slots: " << slots.size() << " booked" << std::endl;
+    logPhase("Load appointment slots");
+
+    // Patient counts for GET /stats, following the user_stats table that
+    // triggers keep in every writer transaction.
+    PatientStats stats;
+    if (!stats.load(*db))
+        return 1;
+    logPhase("Load patient statistics");
+
+    // Change events for open dashboards, published from the same commit hooks.
+    ChangeFeed feed;
+    feed.start();
+
+    // Fans committed changes out to the cache and the feed.
+    PatientMirror mirror(cache, feed);
+
+    // All users mutations go through one writer thread that group-commits
+    // whatever has queued up since its last transaction.
+    WriteQueue writer(pool);
+    writer.addListener(slots);
+    writer.addListener(stats);
+    if (!writer.start())
+        return 1;
+
+    // Who changed which patient and when, appended to segment files by a
+    // background thread; the commit hooks below queue each change without
+    // waiting for the disk. The ring holds a whole /users/bulk chunk.
+    AuditJournal audit(config.auditDir, static_cast<uint64_t>(config.auditSegmentMb) << 20,
+                       std::chrono::milliseconds(config.auditFlushMs));
+    if (!audit.start())
+        return 1;
+
+    // Login sessions, one per browser, identified by the hms_session cookie.
+    SessionStore sessions(std::chrono::hours(8));
+    sessions.startSweeper();
+    // Both lambdas hand a session whose cookie needs a fresh Max-Age to
+    // SessionMiddleware, which re-sends it with the response.
+    app.get_middleware<SessionMiddleware>().sessions = &sessions;
+    auto validateSession = [&sessions, &app](const crow::request &req, std::string *who) {
+        std::string token = sessionCookie(req.get_header_value("Cookie"));
+        bool renewCookie = false;
+        if (!sessions.validate(token, who, &renewCookie))
+            return false;
+        if (renewCookie)
+            app.get_context<SessionMiddleware>(req).renewToken = std::move(token);
+        return true;
+    };
+    auto loggedIn = [&validateSession](const crow::request &req) { return validateSession(req, nullptr); };
+    // As loggedIn, also giving the user's name for the audit journal.
+    auto sessionUser = [&validateSession](const crow::request &req, std::string &who) {
+        return validateSession(req, &who);
+    };
+
+    // Sheds load before it reaches the handlers; see AdmissionMiddleware.
+    AdmissionLimits limits;
+    limits.ratePerSecond = static_cast<double>(config.rateLimit);
+    limits.burst = static_cast<double>(config.rateBurst);
+    limits.maxReads = config.maxReads;
+    limits.maxWrites = config.maxWrites;
+    limits.maxInFlight = static_cast<int>(workerThreads(config));
+    limits.maxQueued = config.admissionQueue;
+    limits.maxWait = std::chrono::milliseconds(config.admissionWaitMs);
+    AdmissionControl admission(limits);
+    app.get_middleware<AdmissionMiddleware>().control = &admission;
+    app.get_middleware<AdmissionMiddleware>().trustForwardedFor = config.trustForwardedFor;
+
+    // The HTML pages never change while the server runs, so build them and
+    // their compressed encodings once. Public pages may be cached briefly;
+    // the dashboard is revalidated on every load so logout still redirects.
+    const StaticPage landingPage(kLandingPageHtml, "text/html; charset=utf-8", "public, max-age=300");
+    const StaticPage loginPage(kLoginPageHtml, "text/html; charset=utf-8", "public, max-age=300");
+    const StaticPage aboutPage(kAboutPageHtml, "text/html; charset=utf-8", "public, max-age=300");
+    const StaticPage dashboardPage(kDashboardPageHtml, "text/html; charset=utf-8", "private, no-cache");
+
 // Public landing page (accessible by everyone)
-CROW_ROUTE(app, "/")([]() {
-    std::ostringstream page;
-    page << R"(
-    <html>
-    <head>
-        <title>Welcome — Hospital Management (HMS) </title>
-        <style>
-            body { font-family: Arial, sans-serif; background: #f7fbff; display:flex; align-items:center; justify-content:center; height:100vh; }
-            .box { width:420px; background:white; padding:24px; border-radius:8px; box-shadow:0 6px 20px rgba(0,0,0,0.08); text-align:center; }
-            a { display:inline-block; margin:10px; padding:10px 16px; border-radius:6px; text-decoration:none; border:1px solid #007bff; color:#007bff; }
-            a.primary { background:#007bff; color:white; border:none; }
-        </style>
-    </head>
-    <body>
-        <div class='box'>
-            <h1>Welcome to HMS</h1>
-            <p>Manage patient appointments and records quickly.</p>
-            <div>
-                <a href="/login" class="primary">Login</a>
-                <a href="/about">About</a>
-            </div>
-        </div>
-    </body>
-    </html>
-    )";
-    return crow::response(page.str());
+CROW_ROUTE(app, "/")([&landingPage](const crow::request &req) {
+    return landingPage.serve(req);
 });
 
-CROW_ROUTE(app, "/login")([]() {
-    std::ostringstream page;
-    page << R"(
-    <html>
-    <head>
-        <title>Login Page</title>
-        <style>
-            body {
-                font-family: Arial;
-                background: #e9f0ff;
-                display: flex;
-                justify-content: center;
-                align-items: center;
-                height: 100vh;
-            }
-            .box {
-                width: 350px;
-                background: white;
-                padding: 25px;
-                border-radius: 10px;
-                box-shadow: 0 4px 10px rgba(0,0,0,0.2);
-            }
-            input, button {
-                width: 100%;
-                padding: 10px;
-                margin: 8px 0;
-                border-radius: 5px;
-                border: 1px solid #aaa;
-            }
-            button {
-                background: #007bff;
-                color: white;
-                border: none;
-                cursor: pointer;
-            }
-        </style>
-    </head>
-    <body>
-        <div class='box'>
-            <h2 style='text-align:center;'>Login</h2>
-            <input id='username' placeholder='Enter username'>
-            <input id='password' type='password' placeholder='Enter password'>
-            <button onclick='login()'>Login</button>
-        </div>
-
-        <script>
-            async function login() {
-                let username = document.getElementById("username").value;
-                let password = document.getElementById("password").value;
-
-                let res = await fetch("/auth", {
-                    method: "POST",
-                    headers: { "Content-Type": "application/json" },
-                    body: JSON.stringify({ username, password })
-                });
+CROW_ROUTE(app, "/login")([&loginPage](const crow::request &req) {
+    return loginPage.serve(req);
+});
+CROW_ROUTE(app, "/logout")([&sessions](const crow::request &req){
+    sessions.revoke(sessionCookie(req.get_header_value("Cookie")));
+    crow::response res(302, "<script>window.location='/login';</script>");
+    res.set_header("Location", "/login");
+    res.set_header("Set-Cookie", sessionSetCookie("", std::chrono::seconds(0)));
+    return res;
+});
 
-                if (res.status === 200) {
-                    window.location.href = "/dashboard";
-                } else {
-                    alert("Incorrect Username or Password!");
-                }
-            }
-        </script>
-    </body>
-    </html>
-    )";
-    return crow::response(page.str());
+CROW_ROUTE(app, "/about")([&aboutPage](const crow::request &req) {
+    return aboutPage.serve(req);
+});
+
+
+CROW_ROUTE(app, "/auth").methods("POST"_method)([&](const crow::request& req){
+    ArenaScope scope;
+    JsonView request(scope.arena());
+    JsonView::Value data = request.parse(req.body) ? request.root() : JsonView::Value();
+    std::string_view username, password;
+    if (!readString(data, "username", username) || !readString(data, "password", password))
+        return crow::response(400, "Invalid");
+
+    DbConnection *conn = pool.local();
+    if (!conn)
+        return crow::response(500, "Database error");
+
+    bool ok = false;
+    {
+        Stmt stmt(*conn, "SELECT 1 FROM accounts WHERE username=? AND password=?;");
+        if (!stmt)
+            return crow::response(500, "Database error");
+        bindView(stmt, 1, username);
+        bindView(stmt, 2, password);
+        if (sqlite3_step(stmt) == SQLITE_ROW) ok = true;
+    }
+
+    if (ok) {
+        crow::response res(200, "Login OK");
+        res.set_header("Set-Cookie", sessionSetCookie(sessions.create(std::string(username)), sessions.ttl()));
+        return res;
+    }
+
+    return crow::response(401, "Invalid credentials");
 });
-CROW_ROUTE(app, "/logout")([&](){
-    isLoggedIn = false;
-    return crow::response(302, "<script>window.location='/login';</script>");
+//Home page
+CROW_ROUTE(app, "/dashboard")([&](const crow::request &req) {
+    if (!loggedIn(req))
+    {
+        crow::response res(302, "<script>window.location='/login';</script>");
+        res.set_header("Location", "/login");
+        return res;
+    }
+    return dashboardPage.serve(req);
 });
+ // Add User
+    // An appointment with a time of day ("date": "2025-03-07 09:30") books the
+    // doctor for "duration" minutes (HMS_APPOINTMENT_MINUTES if omitted); one
+    // that overlaps another booking of the same doctor is refused with 409.
+    CROW_ROUTE(app, "/add").methods("POST"_method)([&](const crow::request &req) {
+        std::string who;
+        if (!sessionUser(req, who))
+            return crow::response(401, "Login required");
+        ArenaScope scope;
+        JsonView request(scope.arena());
+        JsonView::Value body = request.parse(req.body) ? request.root() : JsonView::Value();
+        Patient patient;
+        if (!readPatientFields(body, patient) || !readOptionalInteger(body, "doctor_id", patient.doctorId))
+            return crow::response(400, "Invalid input");
+        if (!readDuration(body, patient))
+            return crow::response(400, "Invalid duration");
 
-CROW_ROUTE(app, "/about")([]() {
-    std::ostringstream page;
-    page << R"(
-    <html>
-    <head>
-        <title>About Us - HMS</title>
-        <style>
-            body {
-                margin: 0;
-                font-family: 'Segoe UI', sans-serif;
-                background: linear-gradient(135deg, #6dd5fa, #ffffff);
-            }
-            .container {
-                width: 85%;
-                margin: 50px auto;
-                background: white;
-                padding: 40px;
-                border-radius: 16px;
-                box-shadow: 0 12px 25px rgba(0,0,0,0.15);
-            }
-            h1 {
-                text-align: center;
-                color: #007bff;
-                margin-bottom: 10px;
-            }
-            .subtitle {
-                text-align: center;
-                color: #555;
-                margin-bottom: 30px;
-                font-size: 18px;
-            }
-            .section {
-                margin-top: 30px;
+        bool taken = false;
+        WriteResult result = writer.run([&](DbConnection &conn) {
+            WriteResult done;
+            done.rc = insertBooked(conn, slots, patient, taken);
+            return done;
+        }, [&](const WriteResult &) {
+            mirror.inserted(patient);
+            audit.record(who, AuditJournal::Op::Add, patient);
+        });
+        if (taken)
+            return crow::response(409, "Appointment slot already booked");
+        if (result.rc == SQLITE_CONSTRAINT)
+            return crow::response(400, "Unknown doctor");
+        if (!result.ok())
+            return crow::response(500, "Database error");
+
+        return crow::response(200, "User added");
+    });
+
+    // Edit User
+    CROW_ROUTE(app, "/edit").methods("POST"_method)([&](const crow::request &req) {
+        std::string who;
+        if (!sessionUser(req, who))
+            return crow::response(401, "Login required");
+        ArenaScope scope;
+        JsonView request(scope.arena());
+        JsonView::Value body = request.parse(req.body) ? request.root() : JsonView::Value();
+        Patient patient;
+        if (!readInteger(body, "id", patient.id) || !readPatientFields(body, patient))
+            return crow::response(400, "Invalid input");
+        if (!readDuration(body, patient))
+            return crow::response(400, "Invalid duration");
+
+        bool taken = false;
+        WriteResult result = writer.run([&](DbConnection &conn) {
+            WriteResult done;
+            done.rc = updateBooked(conn, slots, patient, done.changes, taken);
+            return done;
+        }, [&](const WriteResult &done) {
+            if (done.changes)
+            {
+                mirror.updated(patient);
+                audit.record(who, AuditJournal::Op::Edit, patient);
             }
-            .section h2 {
-                color: #333;
-                border-left: 5px solid #007bff;
-                padding-left: 10px;
+        });
+        if (taken)
+            return crow::response(409, "Appointment slot already booked");
+        if (!result.ok())
+            return crow::response(500, "Database error");
+
+        return crow::response(200, "User updated");
+    });
+
+    // Delete User
+    CROW_ROUTE(app, "/delete").methods("POST"_method)([&](const crow::request &req) {
+        std::string who;
+        if (!sessionUser(req, who))
+            return crow::response(401, "Login required");
+        ArenaScope scope;
+        JsonView request(scope.arena());
+        JsonView::Value body = request.parse(req.body) ? request.root() : JsonView::Value();
+        sqlite3_int64 id;
+        if (!readInteger(body, "id", id))
+            return crow::response(400, "Invalid input");
+
+        WriteResult result = writer.run([&](DbConnection &conn) {
+            WriteResult done;
+            done.rc = deletePatient(conn, id, done.changes);
+            if (done.changes)
+                slots.cancel(id);
+            return done;
+        }, [&](const WriteResult &done) {
+            if (!done.changes)
+                return;
+            mirror.deleted(id);
+            Patient deleted;
+            deleted.id = id;
+            audit.record(who, AuditJournal::Op::Delete, deleted);
+        });
+        if (!result.ok())
+            return crow::response(500, "Database error");
+
+        return crow::response(200, "User deleted");
+    });
+
+    // Batch: a JSON array of {"op": "add"|"edit"|"delete", ...} objects with
+    // the same fields /add, /edit and /delete take. Every operation is
+    // validated before anything runs; then all of them execute as one writer
+    // job, so they commit together or not at all. Edits and deletes of ids
+    // that no longer exist succeed with "changes": 0, so replaying a queue of
+    // offline changes does not fail on rows someone else already removed.
+    CROW_ROUTE(app, "/batch").methods("POST"_method)([&](const crow::request &req) {
+        std::string who;
+        if (!sessionUser(req, who))
+            return crow::response(401, "Login required");
+        ArenaScope scope;
+        JsonView request(scope.arena());
+        JsonView::Value body = request.parse(req.body) ? request.root() : JsonView::Value();
+        if (body.t() != JsonView::Type::List)
+            return crow::response(400, "Expected a JSON array of operations");
+        if (body.size() > kMaxBatchOps)
+            return crow::response(413, "Too many operations");
+
+        std::vector<BatchOp> ops(body.size());
+        std::string invalid;
+        JsonWriter invalidJson(invalid);
+        size_t index = 0;
+        for (JsonView::Value item : body)
+        {
+            const char *error = parseBatchOp(item, ops[index]);
+            if (error)
+            {
+                invalidJson.raw(invalid.empty() ? '[' : ',');
+                invalidJson.raw("{\"index\":", 9);
+                invalidJson.integer(index);
+                invalidJson.raw(",\"error\":", 9);
+                invalidJson.string(error, std::strlen(error));
+                invalidJson.raw('}');
             }
-            .section p {
-                color: #555;
-                line-height: 1.8;
-                font-size: 16px;
+            ++index;
+        }
+        if (!invalid.empty())
+        {
+            std::string reply;
+            JsonWriter json(reply);
+            json.raw("{\"committed\":false,\"errors\":", 28);
+            json.raw(invalid.data(), invalid.size());
+            json.raw("]}", 2);
+            crow::response res(400, std::move(reply));
+            res.set_header("Content-Type", "application/json");
+            return res;
+        }
+
+        size_t failed = ops.size();
+        std::string failure;
+        WriteResult result = writer.run([&](DbConnection &conn) {
+            WriteResult done;
+            for (size_t i = 0; i < ops.size() && done.ok(); ++i)
+            {
+                BatchOp &op = ops[i];
+                bool taken = false;
+                if (op.kind == BatchOp::Kind::Add)
+                {
+                    done.rc = insertBooked(conn, slots, op.patient, taken);
+                    op.changes = done.ok() ? 1 : 0;
+                }
+                else if (op.kind == BatchOp::Kind::Edit)
+                    done.rc = updateBooked(conn, slots, op.patient, op.changes, taken);
+                else
+                {
+                    done.rc = deletePatient(conn, op.patient.id, op.changes);
+                    if (op.changes)
+                        slots.cancel(op.patient.id);
+                }
+                if (!done.ok())
+                {
+                    failed = i;
+                    failure = taken ? kSlotTaken : sqlite3_errmsg(conn.handle());
+                }
             }
-            .cards {
-                display: flex;
-                gap: 20px;
-                margin-top: 25px;
-                flex-wrap: wrap;
+            return done;
+        }, [&](const WriteResult &) {
+            for (const BatchOp &op : ops)
+            {
+                if (!op.changes)
+                    continue;
+                if (op.kind == BatchOp::Kind::Add)
+                {
+                    mirror.inserted(op.patient);
+                    audit.record(who, AuditJournal::Op::Add, op.patient);
+                }
+                else if (op.kind == BatchOp::Kind::Edit)
+                {
+                    mirror.updated(op.patient);
+                    audit.record(who, AuditJournal::Op::Edit, op.patient);
+                }
+                else
+                {
+                    mirror.deleted(op.patient.id);
+                    audit.record(who, AuditJournal::Op::Delete, op.patient);
+                }
             }
-            .card {
-                flex: 1;
-                background: #f5f9ff;
-                padding: 20px;
-                border-radius: 12px;
-                box-shadow: 0 4px 10px rgba(0,0,0,0.1);
-                min-width: 220px;
+        });
+
+        std::string reply;
+        JsonWriter json(reply);
+        if (!result.ok())
+        {
+            json.raw("{\"committed\":false", 18);
+            if (failed < ops.size())
+            {
+                json.raw(",\"errors\":[{\"index\":", 20);
+                json.integer(failed);
+                json.raw(",\"error\":", 9);
+                json.string(failure.data(), failure.size());
+                json.raw("}]", 2);
             }
-            .card h3 {
-                color: #007bff;
-                margin-bottom: 10px;
+            json.raw('}');
+            crow::response res(result.rc == SQLITE_CONSTRAINT ? 409 : 500, std::move(reply));
+            res.set_header("Content-Type", "application/json");
+            return res;
+        }
+
+        json.raw("{\"committed\":true,\"results\":[", 29);
+        for (size_t i = 0; i < ops.size(); ++i)
+        {
+            if (i)
+                json.raw(',');
+            json.raw("{\"op\":\"", 7);
+            const char *name = batchOpName(ops[i].kind);
+            json.raw(name, std::strlen(name));
+            json.raw("\",\"id\":", 7);
+            json.integer(ops[i].patient.id);
+            json.raw(",\"changes\":", 11);
+            json.integer(ops[i].changes);
+            json.raw('}');
+        }
+        json.raw("]}", 2);
+
+        crow::response res(std::move(reply));
+        res.set_header("Content-Type", "application/json");
+        return res;
+    });
+
+    // Get users. With no parameters this returns the whole table, as before,
+    // straight from the in-memory cache: its version is the ETag, so a client
+    // that already has the current list gets a 304 and SQLite is not touched.
+    // `after_id` and `limit` page through it by rowid (keyset pagination); when
+    // a page is full, X-Next-After-Id carries the cursor for the next one.
+    // `stream=1` spools rows to disk as they are stepped and has Crow send the
+    // file once it is complete, so memory stays flat however large the result
+    // is. This is spool-then-send, not streaming: the first byte waits for
+    // the last row, so time to first byte is no better than a whole-table
+    // read. Crow's handlers return a finished response and it has no way to
+    // send a body in chunks as it is produced, so the spool is as close to
+    // streaming as this server gets; see Spool.
+    //
+    // The Accept header selects JSON, CBOR, MessagePack or CSV, and bodies of
+    // kCompressMinBytes or more are compressed with zstd or gzip when
+    // Accept-Encoding allows; spooled bodies are compressed as they are
+    // written. Whole-table bodies in every format and coding are built once
+    // per cache version and kept with its snapshot: JSON from the cache
+    // itself, the other formats read from SQLite after the snapshot was
+    // taken, so they hold at least every change its ETag stands for.
+    CROW_ROUTE(app, "/users")([&pool, &cache, &loggedIn](const crow::request &req) {
+        if (!loggedIn(req))
+            return crow::response(401, "Login required");
+        UserFormat format = UserFormat::Json;
+        if (!negotiateUserFormat(req.get_header_value("Accept"),
+                                 {UserFormat::Json, UserFormat::Cbor, UserFormat::MsgPack, UserFormat::Csv}, format))
+            return crow::response(406, "Available: application/json, application/cbor, application/msgpack, text/csv");
+        ContentCoding coding = negotiateCoding(req.get_header_value("Accept-Encoding"));
+
+        sqlite3_int64 afterId = 0;
+        sqlite3_int64 limit = -1;
+        const char *afterParam = req.url_params.get("after_id");
+        const char *limitParam = req.url_params.get("limit");
+        const char *spoolParam = req.url_params.get("stream");
+        bool spooled = spoolParam && std::string(spoolParam) == "1";
+        bool wholeTable = !afterParam && !limitParam && !spooled;
+
+        std::string versionTag;
+        if (wholeTable)
+        {
+            versionTag = cache.etag();
+            if (usersEtagMatches(req.get_header_value("If-None-Match"), versionTag, format))
+            {
+                crow::response res(304);
+                res.set_header("ETag", usersEtag(versionTag, format, ContentCoding::Identity));
+                res.set_header("Cache-Control", "private, no-cache");
+                setListEncoding(res, ContentCoding::Identity);
+                return res;
             }
-            .back-btn {
-                margin-top: 40px;
-                display: inline-block;
-                padding: 12px 20px;
-                background: #007bff;
-                color: white;
-                border-radius: 8px;
-                text-decoration: none;
-                transition: 0.3s;
+        }
+
+        if (wholeTable)
+        {
+            auto snapshot = cache.snapshot();
+            crow::response res;
+            ContentCoding applied = ContentCoding::Identity;
+            if (format == UserFormat::Json && coding == ContentCoding::Identity)
+                res.body = snapshot->body;
+            else
+            {
+                int key = static_cast<int>(format) * 4 + static_cast<int>(coding);
+                auto variant = snapshot->variant(key, [&](PatientCache::Variant &built) {
+                    if (format == UserFormat::Json)
+                        built.body = snapshot->body;
+                    else
+                    {
+                        DbConnection *conn = pool.local();
+                        if (!conn)
+                            return false;
+                        Stmt all(*conn, "SELECT id, name, phone, disease, date FROM users ORDER BY id");
+                        if (!all)
+                            return false;
+                        sqlite3_int64 lastId = 0;
+                        appendUserList(built.body, all, format, lastId);
+                    }
+                    built.coding = static_cast<int>(compressBody(built.body, coding));
+                    return true;
+                });
+                if (!variant)
+                    return crow::response(500, "Database error");
+                res.body = variant->body;
+                applied = static_cast<ContentCoding>(variant->coding);
             }
-            .back-btn:hover {
-                background: #0056b3;
+            res.set_header("Content-Type", userListLayout(format).contentType);
+            res.set_header("ETag", usersEtag(snapshot->etag, format, applied));
+            res.set_header("Cache-Control", "private, no-cache");
+            setListEncoding(res, applied);
+            return res;
+        }
+
+        if (afterParam && !parseInt64(afterParam, afterId))
+            return crow::response(400, "Invalid after_id");
+        if (limitParam)
+        {
+            if (!parseInt64(limitParam, limit) || limit <= 0)
+                return crow::response(400, "Invalid limit");
+        }
+        else if (afterParam && !spooled)
+        {
+            limit = kDefaultPageSize;
+        }
+        if (!spooled && !wholeTable && limit > kMaxPageSize)
+            limit = kMaxPageSize;
+
+        DbConnection *conn = pool.local();
+        if (!conn)
+            return crow::response(500, "Database error");
+        Stmt stmt(*conn, "SELECT id, name, phone, disease, date FROM users WHERE id > ? ORDER BY id LIMIT ?");
+        Stmt countStmt(*conn, "SELECT count(*) FROM (SELECT 1 FROM users WHERE id > ? ORDER BY id LIMIT ?)");
+        if (!stmt || !countStmt)
+            return crow::response(500, "Database error");
+        sqlite3_bind_int64(stmt, 1, afterId);
+        sqlite3_bind_int64(stmt, 2, limit);
+        sqlite3_bind_int64(countStmt, 1, afterId);
+        sqlite3_bind_int64(countStmt, 2, limit);
+
+        if (spooled)
+            return spoolUsers(*conn, stmt, countStmt, format, coding);
+
+        ArenaScope scope;
+        std::string &body = scope.arena().buffer();
+        sqlite3_int64 lastId = 0;
+        sqlite3_int64 rowCount = appendUserList(body, stmt, format, lastId);
+
+        crow::response res(scope.arena().takeBuffer());
+        res.set_header("Content-Type", userListLayout(format).contentType);
+        setListEncoding(res, compressBody(res.body, coding));
+        if (limit > 0 && rowCount == limit)
+            res.set_header("X-Next-After-Id", std::to_string(lastId));
+        return res;
+    });
+
+    // Server-Sent Events feed of users changes for the dashboard. Each
+    // response is a long poll that Crow completes from the feed's thread; see
+    // ChangeFeed. `last_event_id` stands in for the header when resuming by hand.
+    CROW_ROUTE(app, "/users/changes")([&feed, &loggedIn](const crow::request &req, crow::response &res) {
+        if (!loggedIn(req))
+        {
+            res.code = 401;
+            res.end("Login required");
+            return;
+        }
+        std::string lastEventId = req.get_header_value("Last-Event-ID");
+        const char *lastEventParam = req.url_params.get("last_event_id");
+        if (lastEventId.empty() && lastEventParam)
+            lastEventId = lastEventParam;
+        feed.subscribe(lastEventId, res);
+    });
+
+    // Bulk import: NDJSON (default) or CSV, chosen by ?format= or the
+    // Content-Type. Records are parsed one at a time and inserted in chunks of
+    // kBulkChunkRows through the cached insert statement, each chunk a single
+    // writer job. Rejected rows are counted and the first few are described.
+    CROW_ROUTE(app, "/users/bulk").methods("POST"_method)([&](const crow::request &req) {
+        std::string who;
+        if (!sessionUser(req, who))
+            return crow::response(401, "Login required");
+        const char *formatParam = req.url_params.get("format");
+        std::string format = formatParam ? formatParam : "";
+        if (format.empty())
+            format = req.get_header_value("Content-Type").find("csv") != std::string::npos ? "csv" : "ndjson";
+        if (format != "csv" && format != "ndjson")
+            return crow::response(400, "Unsupported format");
+
+        // Records hold views into the arena, which is released after each
+        // chunk is written.
+        ArenaScope scope;
+        BulkReader reader(req.body, format == "csv" ? BulkReader::Format::Csv : BulkReader::Format::Ndjson,
+                          scope.arena());
+        size_t accepted = 0, rejected = 0;
+        std::string errors;
+        JsonWriter errorJson(errors);
+        auto reject = [&](const BulkRecord &record, const char *error) {
+            if (rejected++ >= kBulkMaxErrors)
+                return;
+            if (!errors.empty())
+                errorJson.raw(',');
+            errorJson.raw("{\"line\":", 8);
+            errorJson.integer(record.line);
+            errorJson.raw(",\"error\":", 9);
+            errorJson.string(error, std::strlen(error));
+            errorJson.raw('}');
+        };
+
+        std::vector<BulkRecord> chunk;
+        std::vector<std::string> stepErrors;
+        auto flush = [&]() {
+            if (chunk.empty())
+                return;
+            stepErrors.assign(chunk.size(), std::string());
+            WriteResult result = writer.run([&](DbConnection &conn) {
+                for (size_t i = 0; i < chunk.size(); ++i)
+                {
+                    bool taken = false;
+                    if (insertBooked(conn, slots, chunk[i].patient, taken) != SQLITE_DONE)
+                        stepErrors[i] = taken ? kSlotTaken : sqlite3_errmsg(conn.handle());
+                }
+                return WriteResult();
+            }, [&](const WriteResult &) {
+                for (const BulkRecord &record : chunk)
+                {
+                    if (!record.patient.id)
+                        continue;
+                    mirror.inserted(record.patient);
+                    audit.record(who, AuditJournal::Op::Add, record.patient);
+                }
+            });
+
+            for (size_t i = 0; i < chunk.size(); ++i)
+            {
+                if (!result.ok())
+                    reject(chunk[i], "database error");
+                else if (chunk[i].patient.id)
+                    ++accepted;
+                else
+                    reject(chunk[i], stepErrors[i].c_str());
             }
-            footer {
-                text-align: center;
-                margin-top: 40px;
-                color: #777;
-                font-size: 14px;
+            chunk.clear();
+            scope.arena().release();
+        };
+
+        BulkRecord record;
+        while (reader.next(record))
+        {
+            if (!record.error.empty())
+            {
+                reject(record, record.error.c_str());
+                continue;
             }
-        </style>
-    </head>
-
-    <body>
-        <div class="container">
-            <h1>About Our Hospital Management System</h1>
-            <div class="subtitle">Smart Healthcare | Simple Management | Secure Records</div>
-
-            <div class="section">
-                <h2>Our Mission</h2>
-                <p>
-                    Our mission is to simplify hospital operations through a modern, secure,
-                    and user-friendly Hospital Management System that improves efficiency,
-                    reduces paperwork, and ensures better patient care.
-                </p>
-            </div>
-
-            <div class="section">
-                <h2>What We Do</h2>
-                <p>
-                    Our HMS helps hospitals manage patient records, appointments, and medical
-                    data digitally with accuracy and speed. It allows staff to focus more on
-                    patient care rather than manual documentation.
-                </p>
-            </div>
-
-            <div class="section">
-                <h2>Why Choose Us?</h2>
-                <div class="cards">
-                    <div class="card">
-                        <h3>✅ Secure Data</h3>
-                        <p>All patient data is safely stored with proper authentication.</p>
-                    </div>
-                    <div class="card">
-                        <h3>⚡ Fast Access</h3>
-                        <p>Quick access to appointments and records in real time.</p>
-                    </div>
-                    <div class="card">
-                        <h3>💻 User Friendly</h3>
-                        <p>Simple interface that anyone can use without training.</p>
-                    </div>
-                </div>
-            </div>
-
-            <div class="section">
-                <h2>Our Vision</h2>
-                <p>
-                    We aim to digitize healthcare services and make hospital operations smarter,
-                    faster, and more reliable for both patients and healthcare professionals.
-                </p>
-            </div>
-
-            <center>
-                <a href="/" class="back-btn">← Back to Home</a>
-            </center>
-
-            <footer>
-                © 2025 Hospital Management System | Developed for Academic Project
-            </footer>
-        </div>
-    </body>
-    </html>
-    )";
-    return crow::response(page.str());
-});
+            chunk.push_back(std::move(record));
+            if (chunk.size() == kBulkChunkRows)
+                flush();
+        }
+        flush();
 
+        std::string body;
+        JsonWriter json(body);
+        json.raw("{\"accepted\":", 12);
+        json.integer(accepted);
+        json.raw(",\"rejected\":", 12);
+        json.integer(rejected);
+        json.raw(",\"errors\":[", 11);
+        json.raw(errors.data(), errors.size());
+        json.raw("]}", 2);
 
-CROW_ROUTE(app, "/auth").methods("POST"_method)([&](const crow::request& req){
-    auto data = crow::json::load(req.body);
-    if (!data || !data.has("username") || !data.has("password"))
-        return crow::response(400, "Invalid");
+        crow::response res(std::move(body));
+        res.set_header("Content-Type", "application/json");
+        return res;
+    });
 
-    std::string username = data["username"].s();
-    std::string password = data["password"].s();
+    // Ranked prefix search over name, disease and phone, answered from the
+    // users_fts index rather than a scan of users.
+    CROW_ROUTE(app, "/users/search")([&pool, &loggedIn](const crow::request &req) {
+        if (!loggedIn(req))
+            return crow::response(401, "Login required");
+        const char *queryParam = req.url_params.get("q");
+        std::string match = ftsPrefixQuery(queryParam ? queryParam : "");
+        if (match.empty())
+            return crow::response(400, "Missing search text");
 
-    sqlite3_stmt *stmt;
-    sqlite3_prepare_v2(db, "SELECT * FROM accounts WHERE username=? AND password=?;", -1, &stmt, nullptr);
-    sqlite3_bind_text(stmt, 1, username.c_str(), -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 2, password.c_str(), -1, SQLITE_STATIC);
+        sqlite3_int64 limit = kDefaultSearchResults;
+        const char *limitParam = req.url_params.get("limit");
+        if (limitParam && (!parseInt64(limitParam, limit) || limit <= 0))
+            return crow::response(400, "Invalid limit");
+        if (limit > kMaxSearchResults)
+            limit = kMaxSearchResults;
 
-    bool ok = false;
-    if (sqlite3_step(stmt) == SQLITE_ROW) ok = true;
+        DbConnection *conn = pool.local();
+        if (!conn)
+            return crow::response(500, "Database error");
+        Stmt stmt(*conn, "SELECT u.id, u.name, u.phone, u.disease, u.date FROM users_fts "
+                         "JOIN users u ON u.id = users_fts.rowid "
+                         "WHERE users_fts MATCH ? ORDER BY rank LIMIT ?");
+        if (!stmt)
+            return crow::response(500, "Database error");
+        sqlite3_bind_text(stmt, 1, match.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_int64(stmt, 2, limit);
+
+        ArenaScope scope;
+        std::string &body = scope.arena().buffer();
+        body.push_back('[');
+        int rc;
+        while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
+        {
+            if (body.size() > 1)
+                body.push_back(',');
+            appendUserJson(body, stmt);
+        }
+        body.push_back(']');
+        if (rc != SQLITE_DONE)
+            return crow::response(500, "Database error");
 
-    sqlite3_finalize(stmt);
+        crow::response res(scope.arena().takeBuffer());
+        res.set_header("Content-Type", "application/json");
+        return res;
+    });
 
-    if (ok) {
-        isLoggedIn = true;
-        return crow::response(200, "Login OK");
-    }
+    // Appointments between two dates, inclusive, in time order. Bounds take the
+    // same formats as a patient's date; `to` defaults to `from`, so
+    // ?from=2025-03-07 is that day's schedule. Served by a range scan of the
+    // users_date_iso index; rows whose date could not be parsed never match.
+    CROW_ROUTE(app, "/appointments")([&pool, &loggedIn](const crow::request &req) {
+        if (!loggedIn(req))
+            return crow::response(401, "Login required");
+        const char *fromParam = req.url_params.get("from");
+        const char *toParam = req.url_params.get("to");
+        std::string from, to;
+        if (!fromParam || !normalizeDate(fromParam, from))
+            return crow::response(400, "Invalid or missing from");
+        if (!toParam)
+            to = from;
+        else if (!normalizeDate(toParam, to))
+            return crow::response(400, "Invalid to");
+        // '~' sorts after 'T', so a date bound also covers every time that day.
+        to.push_back('~');
 
-    return crow::response(401, "Invalid credentials");
-});
-//Home page
-CROW_ROUTE(app, "/dashboard")([&]() {
-    if (!isLoggedIn)
-        return crow::response(302, "<script>window.location='/login';</script>");
-        std::ostringstream page;
-        page << R"(
-            <html>
-            <head>
-                              <title>Home Page</title>
-             <style>
-                    body {
-                        font-family: Arial, sans-serif;
-                        background:url('hms.png');
-                        background-size: cover;
-                        margin: 0;
-                        padding: 0;
-                    }
-                    .container {
-                        width: 80%;
-                        margin: 40px auto;
-                        background: #fff;
-                        border-radius: 10px;
-                        padding: 20px 40px;
-                        box-shadow: 0 4px 10px rgba(0,0,0,0.1);
-                    }
-                    h2, h3 {
-                        text-align: center;
-                        color: #333;
-                    }
-                    input, button {
-                        padding: 10px;
-                        margin: 5px;
-                        border-radius: 5px;
-                        border: 1px solid #ccc;
-                        font-size: 14px;
-                    }
-                    button {
-                        cursor: pointer;
-                        background-color: #007bff;
-                        color: white;
-                        border: none;
-                        transition: 0.2s;
-                    }
-                    button:hover {
-                        background-color: #0056b3;
-                    }
-                    table {
-                        width: 100%;
-                        border-collapse: collapse;
-                        margin-top: 20px;
-                    }
-                    th, td {
-                        padding: 10px;
-                        border: 1px solid #ddd;
-                        text-align: center;
-                    }
-                    th {
-                        background-color: #007bff;
-                        color: white;
-                    }
-                    tr:nth-child(even) {
-                        background-color: #f9f9f9;
-                    }
-                    .action-btn {
-                        padding: 6px 12px;
-                        font-size: 13px;
-                        border-radius: 4px;
-                        margin: 2px;
-                    }
-                    .edit-btn {
-                        background-color: #28a745;
-                        color: white;
-                        border: none;
-                    }
-                    .edit-btn:hover {
-                        background-color: #1e7e34;
-                    }
-                    .delete-btn {
-                        background-color: #dc3545;
-                        color: white;
-                        border: none;
-                    }
-                    .delete-btn:hover {
-                        background-color: #b02a37;
-                    }
-                    .top-right-icon {
-                       position: absolute;
-                       top: 15px;
-                       right: 20px;
-                    }
-                    .top-right-icon img {
-                            width: 40px;
-                            height: 40px;
-                            cursor: pointer;
-                    }
-                </style>
-                <script>
-                    async function addUser() {
-                        const name = document.getElementById("name").value;
-                        const phone = document.getElementById("phone").value;
-                        const disease = document.getElementById("disease").value;
-                        const date = document.getElementById("date").value;
-                        if (!name || !phone || !disease || !date) {
-                            alert("Name, Phone number, Disease and Appointment Date are required!");
-                            return;
-                        }
-                        await fetch("/add", {
-                            method: "POST",
-                            headers: { "Content-Type": "application/json" },
-                            body: JSON.stringify({ name, phone, disease, date })
-                        });
-                        document.getElementById("name").value = "";
-                        document.getElementById("phone").value = "";
-                        document.getElementById("disease").value = "";
-                        document.getElementById("date").value = "";
-                        loadUsers();
-                    }
+        sqlite3_int64 limit = kDefaultAppointments;
+        const char *limitParam = req.url_params.get("limit");
+        if (limitParam && (!parseInt64(limitParam, limit) || limit <= 0))
+            return crow::response(400, "Invalid limit");
+        if (limit > kMaxAppointments)
+            limit = kMaxAppointments;
 
-                    async function editUser(id) {
-                        const name = prompt("Enter new name:");
-                        const phone = prompt("Enter new phone number:");
-                        const disease = prompt("Enter new disease:");
-                        const date = prompt("Enter new Appointment date");
-                        if (!name || !phone || !disease || !date) {
-                            alert("All fields are required!");
-                            return;
-                        }
-                        await fetch("/edit", {
-                            method: "POST",
-                            headers: { "Content-Type": "application/json" },
-                            body: JSON.stringify({ id, name, phone, disease, date })
-                        });
-                        loadUsers();
-                    }
+        DbConnection *conn = pool.local();
+        if (!conn)
+            return crow::response(500, "Database error");
+        Stmt stmt(*conn, "SELECT id, name, phone, disease, date FROM users "
+                         "WHERE date_iso >= ? AND date_iso <= ? ORDER BY date_iso, id LIMIT ?");
+        if (!stmt)
+            return crow::response(500, "Database error");
+        sqlite3_bind_text(stmt, 1, from.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 2, to.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_int64(stmt, 3, limit);
 
-                    async function deleteUser(id) {
-                        if (!confirm("Are you sure you want to delete this user?")) return;
-                        await fetch("/delete", {
-                            method: "POST",
-                            headers: { "Content-Type": "application/json" },
-                            body: JSON.stringify({ id })
-                        });
-                        loadUsers();
-                    }
+        ArenaScope scope;
+        std::string &body = scope.arena().buffer();
+        body.push_back('[');
+        int rc;
+        while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
+        {
+            if (body.size() > 1)
+                body.push_back(',');
+            appendUserJson(body, stmt);
+        }
+        body.push_back(']');
+        if (rc != SQLITE_DONE)
+            return crow::response(500, "Database error");
 
-                    async function loadUsers() {
-                        const res = await fetch("/users");
-                        const users = await res.json();
-                        let html = "<table><tr><th>ID</th><th>Name</th><th>Phone Number</th><th>Disease</th><th>Appointment Date</th><th>Actions</th></tr>";
-                        for (const u of users) {
-                            html += `<tr>
-                                        <td>${u.id}</td>
-                                        <td>${u.name}</td>
-                                        <td>${u.phone}</td>
-                                        <td>${u.disease}</td>
-                                        <td>${u.date}</td>
-                                        <td>
-                                            <button class='action-btn edit-btn' onclick='editUser(${u.id})'>Edit</button>
-                                            <button class='action-btn delete-btn' onclick='deleteUser(${u.id})'>Delete</button>
-                                        </td>
-                                     </tr>`;
-                        }
-                        html += "</table>";
-                        document.getElementById("users").innerHTML = html;
-                    }
+        crow::response res(scope.arena().takeBuffer());
+        res.set_header("Content-Type", "application/json");
+        return res;
+    });
 
-                    window.onload = loadUsers;
-                </script>
-            </head>
-            <body>
-                <div class='top-right-icon'>
-                <img src='https://cdn-icons-png.flaticon.com/512/3135/3135715.png' alt='icon'>
-                </div>
-                <div class='container'>
-                    <h2>Hospital Management System</h2>
-                    <div style='text-align:center; margin-top:20px;'>
-                        <input type='text' id='name' placeholder='Enter name'>
-                        <input type='text' id='phone' placeholder='Enter phone number'>
-                        <input type='text' id='disease' placeholder='Enter disease'>
-                        <input type='text' id='date' placeholder='Enter Appointment Date'>
-                        <button onclick='addUser()'>Add Patient</button>
-                    </div>
-
-                    <hr>
-                    <h3>All Patients</h3>
-                    <div id='users'></div>
-                </div>
-            </body>
-            </html>
-        )";
-        return crow::response(page.str());
+    // Export every patient, sent from a spool file so memory stays flat
+    // regardless of table size. NDJSON by default; `format` (ndjson, csv,
+    // json, cbor or msgpack) or else the Accept header picks another, and the
+    // body is compressed as it is spooled when Accept-Encoding allows.
+    CROW_ROUTE(app, "/users/export")([&pool, &loggedIn](const crow::request &req) {
+        if (!loggedIn(req))
+            return crow::response(401, "Login required");
+        UserFormat format = UserFormat::Ndjson;
+        const char *formatParam = req.url_params.get("format");
+        if (formatParam)
+        {
+            if (!parseUserFormat(formatParam, format))
+                return crow::response(400, "Unsupported format");
+        }
+        else if (!negotiateUserFormat(req.get_header_value("Accept"),
+                                      {UserFormat::Ndjson, UserFormat::Csv, UserFormat::Cbor, UserFormat::MsgPack,
+                                       UserFormat::Json},
+                                      format))
+            return crow::response(406, "Available: application/x-ndjson, text/csv, application/cbor, "
+                                       "application/msgpack, application/json");
+        ContentCoding coding = negotiateCoding(req.get_header_value("Accept-Encoding"));
+
+        DbConnection *conn = pool.local();
+        if (!conn)
+            return crow::response(500, "Database error");
+        Stmt stmt(*conn, "SELECT id, name, phone, disease, date FROM users ORDER BY id");
+        Stmt countStmt(*conn, "SELECT count(*) FROM users");
+        if (!stmt || !countStmt)
+            return crow::response(500, "Database error");
+        return spoolUsers(*conn, stmt, countStmt, format, coding);
     });
- // Add User
-    CROW_ROUTE(app, "/add").methods("POST"_method)([db](const crow::request &req) {
-        auto body = crow::json::load(req.body);
-        if (!body || !body.has("name") || !body.has("phone") || !body.has("disease") || !body.has("date"))
+
+    // Doctors, with the number of patients assigned to each. The count is a
+    // column kept up to date by triggers, so the list never counts rows.
+    CROW_ROUTE(app, "/doctors")([&pool, &loggedIn](const crow::request &req) {
+        if (!loggedIn(req))
+            return crow::response(401, "Login required");
+        DbConnection *conn = pool.local();
+        if (!conn)
+            return crow::response(500, "Database error");
+        Stmt stmt(*conn, "SELECT id, name, specialty, patient_count FROM doctors ORDER BY id");
+        if (!stmt)
+            return crow::response(500, "Database error");
+
+        std::string body;
+        body.push_back('[');
+        for (int rows = 0; sqlite3_step(stmt) == SQLITE_ROW; ++rows)
+        {
+            if (rows)
+                body.push_back(',');
+            appendDoctorJson(body, stmt);
+        }
+        body.push_back(']');
+
+        crow::response res(std::move(body));
+        res.set_header("Content-Type", "application/json");
+        return res;
+    });
+
+    CROW_ROUTE(app, "/doctors/add").methods("POST"_method)([&writer, &loggedIn](const crow::request &req) {
+        if (!loggedIn(req))
+            return crow::response(401, "Login required");
+        ArenaScope scope;
+        JsonView request(scope.arena());
+        JsonView::Value body = request.parse(req.body) ? request.root() : JsonView::Value();
+        Doctor doctor;
+        if (!readString(body, "name", doctor.name) || !readOptionalString(body, "specialty", doctor.specialty))
             return crow::response(400, "Invalid input");
 
-        std::string name = body["name"].s();
-        std::string phone = body["phone"].s();
-        std::string disease = body["disease"].s();
-        std::string date = body["date"].s();
-
-        std::string sql = "INSERT INTO users (name, phone, disease, date) VALUES (?, ?, ?, ?)";
-        sqlite3_stmt *stmt;
-        sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr);
-        sqlite3_bind_text(stmt, 1, name.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 2, phone.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 3, disease.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 4, date.c_str(), -1, SQLITE_STATIC);
-        sqlite3_step(stmt);
-        sqlite3_finalize(stmt);
+        WriteResult result = writer.run([&](DbConnection &conn) {
+            WriteResult done;
+            done.rc = insertDoctor(conn, doctor);
+            return done;
+        });
+        if (!result.ok())
+            return crow::response(500, "Database error");
 
-        return crow::response(200, "User added");
+        crow::response res("{\"id\":" + std::to_string(doctor.id) + "}");
+        res.set_header("Content-Type", "application/json");
+        return res;
     });
 
-    // Edit User
-    CROW_ROUTE(app, "/edit").methods("POST"_method)([db](const crow::request &req) {
-        auto body = crow::json::load(req.body);
-        if (!body || !body.has("id") || !body.has("name") || !body.has("phone") || !body.has("disease") || !body.has("date"))
+    CROW_ROUTE(app, "/doctors/edit").methods("POST"_method)([&writer, &loggedIn](const crow::request &req) {
+        if (!loggedIn(req))
+            return crow::response(401, "Login required");
+        ArenaScope scope;
+        JsonView request(scope.arena());
+        JsonView::Value body = request.parse(req.body) ? request.root() : JsonView::Value();
+        Doctor doctor;
+        if (!readInteger(body, "id", doctor.id) || !readString(body, "name", doctor.name) ||
+            !readOptionalString(body, "specialty", doctor.specialty))
             return crow::response(400, "Invalid input");
 
-        int id = body["id"].i();
-        std::string name = body["name"].s();
-        std::string phone = body["phone"].s();
-        std::string disease = body["disease"].s();
-        std::string date = body["date"].s();
-        std::string sql = "UPDATE users SET name=?, phone=?, disease=?, date=? WHERE id=?";
-        sqlite3_stmt *stmt;
-        sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr);
-        sqlite3_bind_text(stmt, 1, name.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 2, phone.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 3, disease.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 4, date.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_int(stmt, 5, id);
-        sqlite3_step(stmt);
-        sqlite3_finalize(stmt);
+        WriteResult result = writer.run([&](DbConnection &conn) {
+            WriteResult done;
+            done.rc = updateDoctor(conn, doctor, done.changes);
+            return done;
+        });
+        if (!result.ok())
+            return crow::response(500, "Database error");
+        if (!result.changes)
+            return crow::response(404, "No such doctor");
 
-        return crow::response(200, "User updated");
+        return crow::response(200, "Doctor updated");
     });
 
-    // Delete User
-    CROW_ROUTE(app, "/delete").methods("POST"_method)([db](const crow::request &req) {
-        auto body = crow::json::load(req.body);
-        if (!body || !body.has("id"))
+    // Deleting a doctor leaves its patients unassigned.
+    CROW_ROUTE(app, "/doctors/delete").methods("POST"_method)([&writer, &slots, &loggedIn](const crow::request &req) {
+        if (!loggedIn(req))
+            return crow::response(401, "Login required");
+        ArenaScope scope;
+        JsonView request(scope.arena());
+        JsonView::Value body = request.parse(req.body) ? request.root() : JsonView::Value();
+        sqlite3_int64 id;
+        if (!readInteger(body, "id", id))
             return crow::response(400, "Invalid input");
+        WriteResult result = writer.run([&](DbConnection &conn) {
+            WriteResult done;
+            done.rc = deleteDoctor(conn, id, done.changes);
+            if (done.changes)
+                slots.doctorDeleted(id);
+            return done;
+        });
+        if (!result.ok())
+            return crow::response(500, "Database error");
+        if (!result.changes)
+            return crow::response(404, "No such doctor");
 
-        int id = body["id"].i();
+        return crow::response(200, "Doctor deleted");
+    });
 
-        std::string sql = "DELETE FROM users WHERE id=?";
-        sqlite3_stmt *stmt;
-        sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr);
-        sqlite3_bind_int(stmt, 1, id);
-        sqlite3_step(stmt);
-        sqlite3_finalize(stmt);
+    // Assigns a patient to a doctor; a doctor_id of 0 or null unassigns it.
+    // The patient's appointment moves to that doctor's calendar, so this is
+    // refused with 409 if it would be double-booked there.
+    CROW_ROUTE(app, "/doctors/assign").methods("POST"_method)([&](const crow::request &req) {
+        std::string who;
+        if (!sessionUser(req, who))
+            return crow::response(401, "Login required");
+        ArenaScope scope;
+        JsonView request(scope.arena());
+        JsonView::Value body = request.parse(req.body) ? request.root() : JsonView::Value();
+        sqlite3_int64 patientId, doctorId = 0;
+        if (!readInteger(body, "patient_id", patientId) || !body.has("doctor_id") ||
+            !readOptionalInteger(body, "doctor_id", doctorId))
+            return crow::response(400, "Invalid input");
+        bool taken = false;
+        WriteResult result = writer.run([&](DbConnection &conn) {
+            WriteResult done;
+            done.rc = assignPatient(conn, patientId, doctorId, done.changes);
+            if (done.changes && !slots.reassign(patientId, doctorId))
+            {
+                taken = true;
+                done.rc = SQLITE_CONSTRAINT;
+            }
+            return done;
+        }, [&](const WriteResult &done) {
+            if (!done.changes)
+                return;
+            Patient assigned;
+            assigned.id = patientId;
+            assigned.doctorId = doctorId;
+            audit.record(who, AuditJournal::Op::Assign, assigned);
+        });
+        if (taken)
+            return crow::response(409, "Appointment slot already booked");
+        if (result.rc == SQLITE_CONSTRAINT)
+            return crow::response(400, "Unknown doctor");
+        if (!result.ok())
+            return crow::response(500, "Database error");
+        if (!result.changes)
+            return crow::response(404, "No such patient");
 
-        return crow::response(200, "User deleted");
+        return crow::response(200, "Patient assigned");
     });
 
-    // Get all users
-    CROW_ROUTE(app, "/users")([db]() {
-        crow::json::wvalue result;
-        crow::json::wvalue::list users;
+    // A doctor's patients, paged by id like /users?after_id=&limit=. The
+    // query is a single range of the users_doctor covering index; the total
+    // comes from doctors.patient_count in X-Patient-Count.
+    CROW_ROUTE(app, "/doctors/<int>/patients")([&pool, &loggedIn](const crow::request &req, int doctorId) {
+        if (!loggedIn(req))
+            return crow::response(401, "Login required");
+        sqlite3_int64 afterId = 0;
+        sqlite3_int64 limit = kDefaultPageSize;
+        const char *afterParam = req.url_params.get("after_id");
+        const char *limitParam = req.url_params.get("limit");
+        if (afterParam && !parseInt64(afterParam, afterId))
+            return crow::response(400, "Invalid after_id");
+        if (limitParam && (!parseInt64(limitParam, limit) || limit <= 0))
+            return crow::response(400, "Invalid limit");
+        if (limit > kMaxPageSize)
+            limit = kMaxPageSize;
+
+        DbConnection *conn = pool.local();
+        if (!conn)
+            return crow::response(500, "Database error");
+
+        sqlite3_int64 patientCount;
+        {
+            Stmt doctor(*conn, "SELECT patient_count FROM doctors WHERE id = ?");
+            if (!doctor)
+                return crow::response(500, "Database error");
+            sqlite3_bind_int64(doctor, 1, doctorId);
+            if (sqlite3_step(doctor) != SQLITE_ROW)
+                return crow::response(404, "No such doctor");
+            patientCount = sqlite3_column_int64(doctor, 0);
+        }
 
-        const char *sql = "SELECT id, name, phone, disease, date FROM users";
-        sqlite3_stmt *stmt;
-        sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
+        Stmt stmt(*conn, "SELECT id, name, phone, disease, date FROM users "
+                         "WHERE doctor_id = ? AND id > ? ORDER BY id LIMIT ?");
+        if (!stmt)
+            return crow::response(500, "Database error");
+        sqlite3_bind_int64(stmt, 1, doctorId);
+        sqlite3_bind_int64(stmt, 2, afterId);
+        sqlite3_bind_int64(stmt, 3, limit);
+
+        ArenaScope scope;
+        std::string &body = scope.arena().buffer();
+        body.push_back('[');
+        sqlite3_int64 rowCount = 0;
+        sqlite3_int64 lastId = 0;
         while (sqlite3_step(stmt) == SQLITE_ROW)
         {
-            crow::json::wvalue user;
-            user["id"] = sqlite3_column_int(stmt, 0);
-            user["name"] = (const char *)sqlite3_column_text(stmt, 1);
-            user["phone"] = (const char *)sqlite3_column_text(stmt, 2);
-            user["disease"] = (const char *)sqlite3_column_text(stmt, 3);
-            user["date"] = (const char *)sqlite3_column_text(stmt, 4);
+            if (rowCount++)
+                body.push_back(',');
+            lastId = sqlite3_column_int64(stmt, 0);
+            appendUserJson(body, stmt);
+        }
+        body.push_back(']');
+
+        crow::response res(scope.arena().takeBuffer());
+        res.set_header("Content-Type", "application/json");
+        res.set_header("X-Patient-Count", std::to_string(patientCount));
+        if (rowCount == limit)
+            res.set_header("X-Next-After-Id", std::to_string(lastId));
+        return res;
+    });
+
+    // Earliest free appointment with a doctor (doctor_id, 0 or omitted for
+    // unassigned patients) at or after `after` (any date format /add takes,
+    // now if omitted), `duration` minutes long and within opening hours.
+    // Answered from the slot index alone.
+    CROW_ROUTE(app, "/slots/next")([&slots, &config, &loggedIn](const crow::request &req) {
+        if (!loggedIn(req))
+            return crow::response(401, "Login required");
+        sqlite3_int64 doctorId = 0;
+        sqlite3_int64 duration = config.appointmentMinutes;
+        const char *doctorParam = req.url_params.get("doctor_id");
+        const char *afterParam = req.url_params.get("after");
+        const char *durationParam = req.url_params.get("duration");
+        if (doctorParam && !parseInt64(doctorParam, doctorId))
+            return crow::response(400, "Invalid doctor_id");
+        if (durationParam && (!parseInt64(durationParam, duration) || duration < 1 || duration > 24 * 60))
+            return crow::response(400, "Invalid duration");
+
+        std::string iso;
+        if (afterParam)
+        {
+            if (!normalizeDate(afterParam, iso))
+                return crow::response(400, "Invalid after");
+            if (iso.size() == 10)
+                iso += "T00:00";
+        }
+        else
+        {
+            char now[32];
+            std::time_t t = std::time(nullptr);
+            std::tm tm;
+            localtime_r(&t, &tm);
+            std::strftime(now, sizeof(now), "%Y-%m-%dT%H:%M", &tm);
+            iso = now;
+        }
+        int64_t after = 0, start = 0;
+        isoMinutes(iso, after);
+
+        if (!slots.nextFree(doctorId, after, static_cast<int>(duration), config.openingHour * 60,
+                            config.closingHour * 60, start))
+            return crow::response(404, "No free slot");
 
+        std::string body;
+        JsonWriter json(body);
+        json.raw("{\"doctor_id\":", 13);
+        json.integer(doctorId);
+        std::string from = isoFromMinutes(start), to = isoFromMinutes(start + duration);
+        json.raw(",\"start\":", 9);
+        json.string(from.data(), from.size());
+        json.raw(",\"end\":", 7);
+        json.string(to.data(), to.size());
+        json.raw('}');
+        crow::response res(std::move(body));
+        res.set_header("Content-Type", "application/json");
+        return res;
+    });
 
-            users.push_back(user);
+    // Patient counts: the total, per disease and per appointment day, with
+    // by_day limited to `from`..`to` when given (any date format /add
+    // takes). Served from the in-memory copy of user_stats, so the cost is
+    // the number of groups, however many patients there are.
+    CROW_ROUTE(app, "/stats")([&stats, &loggedIn](const crow::request &req) {
+        if (!loggedIn(req))
+            return crow::response(401, "Login required");
+        std::string from, to;
+        const char *fromParam = req.url_params.get("from");
+        const char *toParam = req.url_params.get("to");
+        if (fromParam && !normalizeDate(fromParam, from))
+            return crow::response(400, "Invalid from");
+        if (toParam && !normalizeDate(toParam, to))
+            return crow::response(400, "Invalid to");
+
+        ArenaScope scope;
+        std::string &body = scope.arena().buffer();
+        stats.render(body, std::string_view(from).substr(0, 10), std::string_view(to).substr(0, 10));
+        crow::response res(scope.arena().takeBuffer());
+        res.set_header("Content-Type", "application/json");
+        res.set_header("Cache-Control", "no-cache");
+        return res;
+    });
+
+    // Online backup into config.backupDir, stepped by the writer thread
+    // between write batches. POST starts one (202, or 409 while another is
+    // running); GET reports the progress of the current or last one.
+    // Backup names carry the time to the millisecond and a per-process
+    // sequence number, so two POSTs in the same instant never share a file.
+    std::atomic<unsigned> backupSeq{0};
+    CROW_ROUTE(app, "/admin/backup").methods("GET"_method, "POST"_method)([&](const crow::request &req) {
+        if (!loggedIn(req))
+            return crow::response(401, "Login required");
+        if (req.method != crow::HTTPMethod::Post)
+            return backupResponse(200, writer.backupProgress());
+
+        auto now = std::chrono::system_clock::now();
+        std::time_t seconds = std::chrono::system_clock::to_time_t(now);
+        long long ms = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count() % 1000;
+        std::tm tm;
+        gmtime_r(&seconds, &tm);
+        char name[80];
+        size_t len = std::strftime(name, sizeof(name), "/hms-%Y%m%d-%H%M%S", &tm);
+        std::snprintf(name + len, sizeof(name) - len, ".%03lld-%u.db", ms, backupSeq.fetch_add(1) + 1);
+        std::string error;
+        if (!writer.startBackup(config.backupDir + name, std::chrono::milliseconds(config.backupStepMs), error))
+        {
+            BackupProgress progress = writer.backupProgress();
+            progress.error = error;
+            return backupResponse(progress.state == "running" ? 409 : 500, progress);
         }
-        sqlite3_finalize(stmt);
-        result = std::move(users);
-        return crow::response(result);
+        return backupResponse(202, writer.backupProgress());
+    });
+
+    // Liveness for the docker-compose healthcheck: the database must answer
+    // a read on this worker's connection.
+    CROW_ROUTE(app, "/health")([&pool]() {
+        DbConnection *conn = pool.local();
+        if (!conn)
+            return crow::response(503, "Database unavailable");
+        Stmt stmt(*conn, "SELECT 1 FROM users LIMIT 1");
+        int rc = stmt ? sqlite3_step(stmt) : SQLITE_ERROR;
+        if (rc != SQLITE_ROW && rc != SQLITE_DONE)
+            return crow::response(503, "Database unavailable");
+        return crow::response(200, "OK");
     });
 
-    app.port(3000).multithreaded().run();
+    // Prometheus scrape endpoint.
+    CROW_ROUTE(app, "/metrics")([&admission, &audit]() {
+        crow::response res(renderMetrics() + admission.renderMetrics() + renderAllocationMetrics() +
+                           audit.renderMetrics());
+        res.set_header("Content-Type", "text/plain; version=0.0.4; charset=utf-8");
+        return res;
+    });
+
+    // Paths that get their own route label in /metrics; anything else is
+    // counted as "other".
+    setMetricsRoutes({"/", "/login", "/logout", "/about", "/auth", "/dashboard", "/add", "/edit", "/delete",
+                      "/batch", "/users", "/users/changes", "/users/bulk", "/users/search", "/appointments",
+                      "/users/export", "/doctors", "/doctors/add", "/doctors/edit", "/doctors/delete",
+                      "/doctors/assign", "/doctors/<int>/patients", "/slots/next", "/stats", "/admin/backup",
+                      "/health", "/metrics"});
+
+    std::cout << "Initialized in "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - initStarted)
+                     .count()
+              << " ms" << std::endl;
+
+    app.port(config.port);
+    if (config.threads)
+        app.concurrency(config.threads);
+    else
+        app.multithreaded();
+    app.run();
 
-    sqlite3_close(db);
+    writer.stop();
+    audit.stop();
+    feed.stop();
 }
  
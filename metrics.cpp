@@ -0,0 +1,262 @@
+#include "metrics.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace
+{
+    // Histogram bucket upper bounds, shared by request and SQLite timings.
+    const int kBuckets = 16;
+    const uint64_t kBoundsNs[kBuckets] = {
+        100000, 250000, 500000, 1000000, 2500000, 5000000, 10000000, 25000000,
+        50000000, 100000000, 250000000, 500000000, 1000000000, 2500000000ull, 5000000000ull, 10000000000ull};
+    const char *const kBoundLabels[kBuckets] = {
+        "0.0001", "0.00025", "0.0005", "0.001", "0.0025", "0.005", "0.01", "0.025",
+        "0.05", "0.1", "0.25", "0.5", "1", "2.5", "5", "10"};
+
+    // Route 0 is "other"; registered routes follow, up to the cap.
+    const int kMaxRoutes = 64;
+    const int kStatusClasses = 5;
+    const char *const kSqliteOps[] = {"prepare", "step", "commit"};
+
+    using Counter = std::atomic<uint64_t>;
+
+    // Only the owning thread writes a block, so a plain load and store is
+    // enough; the atomics just keep concurrent scrapes well defined.
+    inline void bump(Counter &counter, uint64_t n = 1)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    struct Histogram
+    {
+        Counter buckets[kBuckets + 1];  // per bucket, not cumulative; last is +Inf
+        Counter sumNs;
+
+        void observe(uint64_t ns)
+        {
+            int i = 0;
+            while (i < kBuckets && ns > kBoundsNs[i])
+                ++i;
+            bump(buckets[i]);
+            bump(sumNs, ns);
+        }
+    };
+
+    struct ThreadBlock
+    {
+        Counter requests[kMaxRoutes][kStatusClasses];
+        std::atomic<int64_t> inFlight[kMaxRoutes];
+        Histogram latency[kMaxRoutes];
+        Histogram sqlite[3];
+    };
+
+    struct Registry
+    {
+        std::mutex mutex;
+        std::vector<std::shared_ptr<ThreadBlock>> blocks;
+        std::vector<std::string> routes{"other"};
+        std::unordered_map<std::string, int> index;
+    };
+
+    Registry &registry()
+    {
+        static Registry instance;
+        return instance;
+    }
+
+    // The calling thread's block. The registry keeps it alive after the
+    // thread exits so its counts still show up in later scrapes.
+    ThreadBlock &localBlock()
+    {
+        thread_local std::shared_ptr<ThreadBlock> block;
+        if (!block)
+        {
+            block = std::make_shared<ThreadBlock>();
+            Registry &reg = registry();
+            std::lock_guard<std::mutex> lock(reg.mutex);
+            reg.blocks.push_back(block);
+        }
+        return *block;
+    }
+
+    struct HistogramTotals
+    {
+        uint64_t buckets[kBuckets + 1] = {};
+        uint64_t sumNs = 0;
+
+        void add(const Histogram &h)
+        {
+            for (int i = 0; i <= kBuckets; ++i)
+                buckets[i] += h.buckets[i].load(std::memory_order_relaxed);
+            sumNs += h.sumNs.load(std::memory_order_relaxed);
+        }
+    };
+
+    void appendf(std::string &out, const char *format, ...)
+    {
+        char buf[256];
+        va_list args;
+        va_start(args, format);
+        int len = std::vsnprintf(buf, sizeof(buf), format, args);
+        va_end(args);
+        if (len > 0)
+            out.append(buf, std::min<size_t>(len, sizeof(buf) - 1));
+    }
+
+    // Writes the _bucket, _sum and _count lines of one histogram series;
+    // `labels` is the series' other labels followed by a comma, or empty.
+    void appendHistogram(std::string &out, const char *name, const std::string &labels, const HistogramTotals &h)
+    {
+        uint64_t cumulative = 0;
+        for (int i = 0; i < kBuckets; ++i)
+        {
+            cumulative += h.buckets[i];
+            appendf(out, "%s_bucket{%sle=\"%s\"} %llu\n", name, labels.c_str(), kBoundLabels[i],
+                    (unsigned long long)cumulative);
+        }
+        cumulative += h.buckets[kBuckets];
+        appendf(out, "%s_bucket{%sle=\"+Inf\"} %llu\n", name, labels.c_str(), (unsigned long long)cumulative);
+        std::string plain = labels.empty() ? std::string() : "{" + labels.substr(0, labels.size() - 1) + "}";
+        appendf(out, "%s_sum%s %.9f\n", name, plain.c_str(), h.sumNs / 1e9);
+        appendf(out, "%s_count%s %llu\n", name, plain.c_str(), (unsigned long long)cumulative);
+    }
+}
+
+void setMetricsRoutes(const std::vector<std::string> &routes)
+{
+    Registry &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    for (const std::string &route : routes)
+    {
+        if ((int)reg.routes.size() == kMaxRoutes)
+            break;
+        if (reg.index.emplace(route, (int)reg.routes.size()).second)
+            reg.routes.push_back(route);
+    }
+}
+
+int metricsRoute(const std::string &path)
+{
+    // Written only before the server starts, so lookups need no lock.
+    const auto &index = registry().index;
+    auto it = index.find(path);
+    if (it != index.end())
+        return it->second;
+
+    // Paths with numeric segments are counted under their route pattern,
+    // e.g. /doctors/7/patients as /doctors/<int>/patients.
+    std::string pattern;
+    bool numeric = false;
+    for (size_t pos = 0; pos < path.size();)
+    {
+        size_t end = path.find('/', pos + 1);
+        if (end == std::string::npos)
+            end = path.size();
+        size_t digits = pos + 1;
+        while (digits < end && path[digits] >= '0' && path[digits] <= '9')
+            ++digits;
+        if (path[pos] == '/' && digits == end && end > pos + 1)
+        {
+            pattern += "/<int>";
+            numeric = true;
+        }
+        else
+            pattern.append(path, pos, end - pos);
+        pos = end;
+    }
+    if (!numeric)
+        return 0;
+    it = index.find(pattern);
+    return it == index.end() ? 0 : it->second;
+}
+
+void requestStarted(int route)
+{
+    std::atomic<int64_t> &gauge = localBlock().inFlight[route];
+    gauge.store(gauge.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+void requestFinished(int route, int status, std::chrono::nanoseconds elapsed)
+{
+    ThreadBlock &block = localBlock();
+    std::atomic<int64_t> &gauge = block.inFlight[route];
+    gauge.store(gauge.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+
+    int statusClass = status / 100 - 1;
+    if (statusClass < 0 || statusClass >= kStatusClasses)
+        statusClass = kStatusClasses - 1;
+    bump(block.requests[route][statusClass]);
+    block.latency[route].observe(elapsed.count() > 0 ? elapsed.count() : 0);
+}
+
+void recordSqlite(SqliteOp op, std::chrono::nanoseconds elapsed)
+{
+    localBlock().sqlite[(int)op].observe(elapsed.count() > 0 ? elapsed.count() : 0);
+}
+
+std::string renderMetrics()
+{
+    Registry &reg = registry();
+    std::vector<std::shared_ptr<ThreadBlock>> blocks;
+    std::vector<std::string> routes;
+    {
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        blocks = reg.blocks;
+        routes = reg.routes;
+    }
+
+    std::string out;
+    out.reserve(64 * 1024);
+
+    out += "# HELP hms_http_requests_total HTTP requests by route and status class.\n"
+           "# TYPE hms_http_requests_total counter\n";
+    for (size_t r = 0; r < routes.size(); ++r)
+    {
+        for (int c = 0; c < kStatusClasses; ++c)
+        {
+            uint64_t total = 0;
+            for (const auto &block : blocks)
+                total += block->requests[r][c].load(std::memory_order_relaxed);
+            if (total)
+                appendf(out, "hms_http_requests_total{route=\"%s\",code=\"%dxx\"} %llu\n", routes[r].c_str(), c + 1,
+                        (unsigned long long)total);
+        }
+    }
+
+    out += "# HELP hms_http_requests_in_flight HTTP requests currently being handled.\n"
+           "# TYPE hms_http_requests_in_flight gauge\n";
+    for (size_t r = 0; r < routes.size(); ++r)
+    {
+        int64_t total = 0;
+        for (const auto &block : blocks)
+            total += block->inFlight[r].load(std::memory_order_relaxed);
+        appendf(out, "hms_http_requests_in_flight{route=\"%s\"} %lld\n", routes[r].c_str(), (long long)total);
+    }
+
+    out += "# HELP hms_http_request_duration_seconds Time from routing a request to finishing its response.\n"
+           "# TYPE hms_http_request_duration_seconds histogram\n";
+    for (size_t r = 0; r < routes.size(); ++r)
+    {
+        HistogramTotals totals;
+        for (const auto &block : blocks)
+            totals.add(block->latency[r]);
+        appendHistogram(out, "hms_http_request_duration_seconds", "route=\"" + routes[r] + "\",", totals);
+    }
+
+    out += "# HELP hms_sqlite_duration_seconds Time spent preparing statements, executing them and committing.\n"
+           "# TYPE hms_sqlite_duration_seconds histogram\n";
+    for (int op = 0; op < 3; ++op)
+    {
+        HistogramTotals totals;
+        for (const auto &block : blocks)
+            totals.add(block->sqlite[op]);
+        appendHistogram(out, "hms_sqlite_duration_seconds", std::string("op=\"") + kSqliteOps[op] + "\",", totals);
+    }
+    return out;
+}
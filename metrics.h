@@ -0,0 +1,41 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Process-wide request and SQLite metrics, rendered in the Prometheus text
+// exposition format by GET /metrics.
+//
+// Each thread records into its own block of counters, created on the
+// thread's first measurement and never shared for writing, so recording is a
+// relaxed load and store with no locked instructions and no cache-line
+// ping-pong between Crow workers. A scrape sums every block; counts may be a
+// few operations stale but never go backwards.
+
+// Routes that get their own label. Requests for any other path are counted
+// under route="other" so unknown URLs cannot grow the series count. Call
+// once, before the server starts.
+void setMetricsRoutes(const std::vector<std::string> &routes);
+
+// Label index for `path`. Numeric segments also match a registered
+// "<int>" pattern; anything else unregistered maps to "other".
+int metricsRoute(const std::string &path);
+
+// In-flight gauge. The two calls may happen on different threads (async
+// handlers finish on whichever thread completes them); the sum stays right.
+void requestStarted(int route);
+void requestFinished(int route, int status, std::chrono::nanoseconds elapsed);
+
+enum class SqliteOp
+{
+    Prepare,  // sqlite3_prepare_v3 on a statement cache miss
+    Step,     // one use of a cached statement, borrowed to reset
+    Commit,   // COMMIT of a writer batch
+};
+
+void recordSqlite(SqliteOp op, std::chrono::nanoseconds elapsed);
+
+// Everything recorded so far, in Prometheus text format.
+std::string renderMetrics();
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "crow.h"
+#include "metrics.h"
+
+#include <chrono>
+
+// Counts and times every request the app receives, including ones no route
+// matches. Async handlers are timed until they call res.end().
+struct MetricsMiddleware
+{
+    struct context
+    {
+        int route = 0;
+        std::chrono::steady_clock::time_point started;
+    };
+
+    void before_handle(crow::request &req, crow::response &, context &ctx)
+    {
+        ctx.route = metricsRoute(req.url);
+        ctx.started = std::chrono::steady_clock::now();
+        requestStarted(ctx.route);
+    }
+
+    void after_handle(crow::request &, crow::response &res, context &ctx)
+    {
+        requestFinished(ctx.route, res.code, std::chrono::steady_clock::now() - ctx.started);
+    }
+};
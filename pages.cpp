@@ -0,0 +1,486 @@
+#include "pages.h"
+
+// Page markup served by the HTML routes. These are compiled in as constants
+// and turned into StaticPage objects once at startup.
+
+// Public landing page (accessible by everyone)
+const char *const kLandingPageHtml = R"(
+    <html>
+    <head>
+        <title>Welcome — Hospital Management (HMS) </title>
+        <style>
+            body { font-family: Arial, sans-serif; background: #f7fbff; display:flex; align-items:center; justify-content:center; height:100vh; }
+            .box { width:420px; background:white; padding:24px; border-radius:8px; box-shadow:0 6px 20px rgba(0,0,0,0.08); text-align:center; }
+            a { display:inline-block; margin:10px; padding:10px 16px; border-radius:6px; text-decoration:none; border:1px solid #007bff; color:#007bff; }
+            a.primary { background:#007bff; color:white; border:none; }
+        </style>
+    </head>
+    <body>
+        <div class='box'>
+            <h1>Welcome to HMS</h1>
+            <p>Manage patient appointments and records quickly.</p>
+            <div>
+                <a href="/login" class="primary">Login</a>
+                <a href="/about">About</a>
+            </div>
+        </div>
+    </body>
+    </html>
+    )";
+
+// Login form; posts to /auth
+const char *const kLoginPageHtml = R"(
+    <html>
+    <head>
+        <title>Login Page</title>
+        <style>
+            body {
+                font-family: Arial;
+                background: #e9f0ff;
+                display: flex;
+                justify-content: center;
+                align-items: center;
+                height: 100vh;
+            }
+            .box {
+                width: 350px;
+                background: white;
+                padding: 25px;
+                border-radius: 10px;
+                box-shadow: 0 4px 10px rgba(0,0,0,0.2);
+            }
+            input, button {
+                width: 100%;
+                padding: 10px;
+                margin: 8px 0;
+                border-radius: 5px;
+                border: 1px solid #aaa;
+            }
+            button {
+                background: #007bff;
+                color: white;
+                border: none;
+                cursor: pointer;
+            }
+        </style>
+    </head>
+    <body>
+        <div class='box'>
+            <h2 style='text-align:center;'>Login</h2>
+            <input id='username' placeholder='Enter username'>
+            <input id='password' type='password' placeholder='Enter password'>
+            <button onclick='login()'>Login</button>
+        </div>
+
+        <script>
+            async function login() {
+                let username = document.getElementById("username").value;
+                let password = document.getElementById("password").value;
+
+                let res = await fetch("/auth", {
+                    method: "POST",
+                    headers: { "Content-Type": "application/json" },
+                    body: JSON.stringify({ username, password })
+                });
+
+                if (res.status === 200) {
+                    window.location.href = "/dashboard";
+                } else {
+                    alert("Incorrect Username or Password!");
+                }
+            }
+        </script>
+    </body>
+    </html>
+    )";
+
+// About page
+const char *const kAboutPageHtml = R"(
+    <html>
+    <head>
+        <title>About Us - HMS</title>
+        <style>
+            body {
+                margin: 0;
+                font-family: 'Segoe UI', sans-serif;
+                background: linear-gradient(135deg, #6dd5fa, #ffffff);
+            }
+            .container {
+                width: 85%;
+                margin: 50px auto;
+                background: white;
+                padding: 40px;
+                border-radius: 16px;
+                box-shadow: 0 12px 25px rgba(0,0,0,0.15);
+            }
+            h1 {
+                text-align: center;
+                color: #007bff;
+                margin-bottom: 10px;
+            }
+            .subtitle {
+                text-align: center;
+                color: #555;
+                margin-bottom: 30px;
+                font-size: 18px;
+            }
+            .section {
+                margin-top: 30px;
+            }
+            .section h2 {
+                color: #333;
+                border-left: 5px solid #007bff;
+                padding-left: 10px;
+            }
+            .section p {
+                color: #555;
+                line-height: 1.8;
+                font-size: 16px;
+            }
+            .cards {
+                display: flex;
+                gap: 20px;
+                margin-top: 25px;
+                flex-wrap: wrap;
+            }
+            .card {
+                flex: 1;
+                background: #f5f9ff;
+                padding: 20px;
+                border-radius: 12px;
+                box-shadow: 0 4px 10px rgba(0,0,0,0.1);
+                min-width: 220px;
+            }
+            .card h3 {
+                color: #007bff;
+                margin-bottom: 10px;
+            }
+            .back-btn {
+                margin-top: 40px;
+                display: inline-block;
+                padding: 12px 20px;
+                background: #007bff;
+                color: white;
+                border-radius: 8px;
+                text-decoration: none;
+                transition: 0.3s;
+            }
+            .back-btn:hover {
+                background: #0056b3;
+            }
+            footer {
+                text-align: center;
+                margin-top: 40px;
+                color: #777;
+                font-size: 14px;
+            }
+        </style>
+    </head>
+
+    <body>
+        <div class="container">
+            <h1>About Our Hospital Management System</h1>
+            <div class="subtitle">Smart Healthcare | Simple Management | Secure Records</div>
+
+            <div class="section">
+                <h2>Our Mission</h2>
+                <p>
+                    Our mission is to simplify hospital operations through a modern, secure,
+                    and user-friendly Hospital Management System that improves efficiency,
+                    reduces paperwork, and ensures better patient care.
+                </p>
+            </div>
+
+            <div class="section">
+                <h2>What We Do</h2>
+                <p>
+                    Our HMS helps hospitals manage patient records, appointments, and medical
+                    data digitally with accuracy and speed. It allows staff to focus more on
+                    patient care rather than manual documentation.
+                </p>
+            </div>
+
+            <div class="section">
+                <h2>Why Choose Us?</h2>
+                <div class="cards">
+                    <div class="card">
+                        <h3>✅ Secure Data</h3>
+                        <p>All patient data is safely stored with proper authentication.</p>
+                    </div>
+                    <div class="card">
+                        <h3>⚡ Fast Access</h3>
+                        <p>Quick access to appointments and records in real time.</p>
+                    </div>
+                    <div class="card">
+                        <h3>💻 User Friendly</h3>
+                        <p>Simple interface that anyone can use without training.</p>
+                    </div>
+                </div>
+            </div>
+
+            <div class="section">
+                <h2>Our Vision</h2>
+                <p>
+                    We aim to digitize healthcare services and make hospital operations smarter,
+                    faster, and more reliable for both patients and healthcare professionals.
+                </p>
+            </div>
+
+            <center>
+                <a href="/" class="back-btn">← Back to Home</a>
+            </center>
+
+            <footer>
+                © 2025 Hospital Management System | Developed for Academic Project
+            </footer>
+        </div>
+    </body>
+    </html>
+    )";
+
+// Patient dashboard; only served to logged-in users
+const char *const kDashboardPageHtml = R"(
+            <html>
+            <head>
+                              <title>Home Page</title>
+             <style>
+                    body {
+                        font-family: Arial, sans-serif;
+                        background:url('hms.png');
+                        background-size: cover;
+                        margin: 0;
+                        padding: 0;
+                    }
+                    .container {
+                        width: 80%;
+                        margin: 40px auto;
+                        background: #fff;
+                        border-radius: 10px;
+                        padding: 20px 40px;
+                        box-shadow: 0 4px 10px rgba(0,0,0,0.1);
+                    }
+                    h2, h3 {
+                        text-align: center;
+                        color: #333;
+                    }
+                    input, button {
+                        padding: 10px;
+                        margin: 5px;
+                        border-radius: 5px;
+                        border: 1px solid #ccc;
+                        font-size: 14px;
+                    }
+                    button {
+                        cursor: pointer;
+                        background-color: #007bff;
+                        color: white;
+                        border: none;
+                        transition: 0.2s;
+                    }
+                    button:hover {
+                        background-color: #0056b3;
+                    }
+                    table {
+                        width: 100%;
+                        border-collapse: collapse;
+                        margin-top: 20px;
+                    }
+                    th, td {
+                        padding: 10px;
+                        border: 1px solid #ddd;
+                        text-align: center;
+                    }
+                    th {
+                        background-color: #007bff;
+                        color: white;
+                    }
+                    tr:nth-child(even) {
+                        background-color: #f9f9f9;
+                    }
+                    .action-btn {
+                        padding: 6px 12px;
+                        font-size: 13px;
+                        border-radius: 4px;
+                        margin: 2px;
+                    }
+                    .edit-btn {
+                        background-color: #28a745;
+                        color: white;
+                        border: none;
+                    }
+                    .edit-btn:hover {
+                        background-color: #1e7e34;
+                    }
+                    .delete-btn {
+                        background-color: #dc3545;
+                        color: white;
+                        border: none;
+                    }
+                    .delete-btn:hover {
+                        background-color: #b02a37;
+                    }
+                    .top-right-icon {
+                       position: absolute;
+                       top: 15px;
+                       right: 20px;
+                    }
+                    .top-right-icon img {
+                            width: 40px;
+                            height: 40px;
+                            cursor: pointer;
+                    }
+                </style>
+                <script>
+                    async function addUser() {
+                        const name = document.getElementById("name").value;
+                        const phone = document.getElementById("phone").value;
+                        const disease = document.getElementById("disease").value;
+                        const date = document.getElementById("date").value;
+                        if (!name || !phone || !disease || !date) {
+                            alert("Name, Phone number, Disease and Appointment Date are required!");
+                            return;
+                        }
+                        await fetch("/add", {
+                            method: "POST",
+                            headers: { "Content-Type": "application/json" },
+                            body: JSON.stringify({ name, phone, disease, date })
+                        });
+                        document.getElementById("name").value = "";
+                        document.getElementById("phone").value = "";
+                        document.getElementById("disease").value = "";
+                        document.getElementById("date").value = "";
+                    }
+
+                    async function editUser(id) {
+                        const name = prompt("Enter new name:");
+                        const phone = prompt("Enter new phone number:");
+                        const disease = prompt("Enter new disease:");
+                        const date = prompt("Enter new Appointment date");
+                        if (!name || !phone || !disease || !date) {
+                            alert("All fields are required!");
+                            return;
+                        }
+                        await fetch("/edit", {
+                            method: "POST",
+                            headers: { "Content-Type": "application/json" },
+                            body: JSON.stringify({ id, name, phone, disease, date })
+                        });
+                    }
+
+                    async function deleteUser(id) {
+                        if (!confirm("Are you sure you want to delete this user?")) return;
+                        await fetch("/delete", {
+                            method: "POST",
+                            headers: { "Content-Type": "application/json" },
+                            body: JSON.stringify({ id })
+                        });
+                    }
+
+                    function esc(text) {
+                        return String(text).replace(/[&<>"']/g, c => "&#" + c.charCodeAt(0) + ";");
+                    }
+
+                    function userRow(u) {
+                        return `<tr id='user-${u.id}'>
+                                    <td>${u.id}</td>
+                                    <td>${esc(u.name)}</td>
+                                    <td>${esc(u.phone)}</td>
+                                    <td>${esc(u.disease)}</td>
+                                    <td>${esc(u.date)}</td>
+                                    <td>
+                                        <button class='action-btn edit-btn' onclick='editUser(${u.id})'>Edit</button>
+                                        <button class='action-btn delete-btn' onclick='deleteUser(${u.id})'>Delete</button>
+                                    </td>
+                                 </tr>`;
+                    }
+
+                    async function loadUsers() {
+                        const res = await fetch("/users");
+                        const users = await res.json();
+                        let html = "<table id='users-table'><tr><th>ID</th><th>Name</th><th>Phone Number</th><th>Disease</th><th>Appointment Date</th><th>Actions</th></tr>";
+                        for (const u of users) {
+                            html += userRow(u);
+                        }
+                        html += "</table>";
+                        document.getElementById("users").innerHTML = html;
+                    }
+
+                    // Applies one change from /users/changes to the table in place.
+                    // Each carries the whole row, so replaying one the table already has is harmless.
+                    function applyChange(change) {
+                        const table = document.getElementById("users-table");
+                        if (!table) return;
+                        const existing = document.getElementById("user-" + change.id);
+                        if (change.op === "delete") {
+                            if (existing) existing.remove();
+                            return;
+                        }
+                        const holder = document.createElement("tbody");
+                        holder.innerHTML = userRow(change.row);
+                        const row = holder.firstElementChild;
+                        if (existing) existing.replaceWith(row);
+                        else table.tBodies[0].appendChild(row);
+                    }
+
+                    // Changes that arrive while a reset's reload is in flight, or null when
+                    // none is. The fetched list may predate them, and the rebuild would drop
+                    // any applied to the old table, so they are replayed in order after it.
+                    let queuedChanges = null;
+                    let reloadAgain = false;
+
+                    async function resetUsers() {
+                        if (queuedChanges) {
+                            // A reload started after this reset covers everything queued so far.
+                            queuedChanges = [];
+                            reloadAgain = true;
+                            return;
+                        }
+                        queuedChanges = [];
+                        try {
+                            do {
+                                reloadAgain = false;
+                                await loadUsers();
+                            } while (reloadAgain);
+                        } finally {
+                            const changes = queuedChanges;
+                            queuedChanges = null;
+                            changes.forEach(applyChange);
+                        }
+                    }
+
+                    // The server opens every stream with a reset (and sends one again if we
+                    // fall too far behind); after that it only sends the rows that changed.
+                    function watchUsers() {
+                        const feed = new EventSource("/users/changes");
+                        feed.addEventListener("reset", () => resetUsers());
+                        feed.addEventListener("change", e => {
+                            const change = JSON.parse(e.data);
+                            if (queuedChanges) queuedChanges.push(change);
+                            else applyChange(change);
+                        });
+                    }
+
+                    window.onload = watchUsers;
+                </script>
+            </head>
+            <body>
+                <div class='top-right-icon'>
+                <img src='https://cdn-icons-png.flaticon.com/512/3135/3135715.png' alt='icon'>
+                </div>
+                <div class='container'>
+                    <h2>Hospital Management System</h2>
+                    <div style='text-align:center; margin-top:20px;'>
+                        <input type='text' id='name' placeholder='Enter name'>
+                        <input type='text' id='phone' placeholder='Enter phone number'>
+                        <input type='text' id='disease' placeholder='Enter disease'>
+                        <input type='datetime-local' id='date' title='Appointment date and time'>
+                        <button onclick='addUser()'>Add Patient</button>
+                    </div>
+
+                    <hr>
+                    <h3>All Patients</h3>
+                    <div id='users'></div>
+                </div>
+            </body>
+            </html>
+        )";
@@ -0,0 +1,7 @@
+#pragma once
+
+// HTML for the server-rendered pages, defined in pages.cpp.
+extern const char *const kLandingPageHtml;
+extern const char *const kLoginPageHtml;
+extern const char *const kAboutPageHtml;
+extern const char *const kDashboardPageHtml;
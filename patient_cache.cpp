@@ -0,0 +1,169 @@
+#include "patient_cache.h"
+
+#include "user_rows.h"
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+PatientCache::PatientCache()
+{
+    // Versions restart with the process; the epoch keeps a tag handed out by
+    // an earlier run from matching this run's data.
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+    char buf[24];
+    std::snprintf(buf, sizeof(buf), "%llx", (unsigned long long)std::chrono::duration_cast<std::chrono::microseconds>(now).count());
+    epoch_ = buf;
+}
+
+std::string PatientCache::etagFor(uint64_t version) const
+{
+    return "\"" + epoch_ + "-" + std::to_string(version) + "\"";
+}
+
+bool PatientCache::load(DbConnection &conn)
+{
+    Stmt stmt(conn, "SELECT id, name, phone, disease, date FROM users ORDER BY id");
+    if (!stmt)
+        return false;
+
+    std::lock_guard<std::mutex> lock(blocksMutex_);
+    blocks_.clear();
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
+    {
+        sqlite3_int64 id = sqlite3_column_int64(stmt, 0);
+        auto &block = blocks_[id >> kBlockShift];
+        if (!block)
+            block = std::make_shared<Block>();
+        std::string json;
+        appendUserJson(json, stmt);
+        block->rows.emplace_hint(block->rows.end(), id, std::move(json));
+    }
+    version_.fetch_add(1, std::memory_order_release);
+    return rc == SQLITE_DONE;
+}
+
+std::shared_ptr<PatientCache::Block> PatientCache::blockFor(sqlite3_int64 id, bool create)
+{
+    std::lock_guard<std::mutex> lock(blocksMutex_);
+    auto it = blocks_.find(id >> kBlockShift);
+    if (it != blocks_.end())
+        return it->second;
+    if (!create)
+        return nullptr;
+    auto block = std::make_shared<Block>();
+    blocks_.emplace(id >> kBlockShift, block);
+    return block;
+}
+
+void PatientCache::upsert(sqlite3_int64 id, std::string_view name, std::string_view phone,
+                          std::string_view disease, std::string_view date)
+{
+    std::string json;
+    appendUserJson(json, id, name, phone, disease, date);
+
+    auto block = blockFor(id, true);
+    {
+        std::lock_guard<std::mutex> lock(block->mutex);
+        block->rows[id] = std::move(json);
+        block->json.reset();
+    }
+    version_.fetch_add(1, std::memory_order_release);
+}
+
+void PatientCache::remove(sqlite3_int64 id)
+{
+    auto block = blockFor(id, false);
+    if (!block)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(block->mutex);
+        if (!block->rows.erase(id))
+            return;
+        block->json.reset();
+    }
+    version_.fetch_add(1, std::memory_order_release);
+}
+
+std::shared_ptr<const PatientCache::Variant> PatientCache::Snapshot::variant(
+    int key, const std::function<bool(Variant &)> &build) const
+{
+    // Builds are rare (one per key and version), so they simply run under
+    // the lock and concurrent requests for the same variant wait for it.
+    std::lock_guard<std::mutex> lock(variantsMutex_);
+    auto found = variants_.find(key);
+    if (found != variants_.end())
+        return found->second;
+    auto built = std::make_shared<Variant>();
+    if (!build(*built))
+        return nullptr;
+    std::shared_ptr<const Variant> published = std::move(built);
+    variants_.emplace(key, published);
+    return published;
+}
+
+std::shared_ptr<const PatientCache::Snapshot> PatientCache::snapshot()
+{
+    auto current = std::atomic_load(&snapshot_);
+    if (current && current->version == version())
+        return current;
+
+    // Only one reader rebuilds; the others wait here and pick up its result.
+    std::lock_guard<std::mutex> rebuild(rebuildMutex_);
+    current = std::atomic_load(&snapshot_);
+    uint64_t version = this->version();
+    if (current && current->version == version)
+        return current;
+
+    // Read the version before the blocks: the body then holds at least every
+    // change up to `version`, so a client holding its ETag is never stale.
+    std::vector<std::shared_ptr<Block>> blocks;
+    {
+        std::lock_guard<std::mutex> lock(blocksMutex_);
+        blocks.reserve(blocks_.size());
+        for (auto &entry : blocks_)
+            blocks.push_back(entry.second);
+    }
+
+    std::vector<std::shared_ptr<const std::string>> parts;
+    parts.reserve(blocks.size());
+    size_t total = 2;
+    for (auto &block : blocks)
+    {
+        std::lock_guard<std::mutex> lock(block->mutex);
+        if (!block->json)
+        {
+            auto json = std::make_shared<std::string>();
+            for (auto &row : block->rows)
+            {
+                if (!json->empty())
+                    json->push_back(',');
+                json->append(row.second);
+            }
+            block->json = std::move(json);
+        }
+        if (!block->json->empty())
+        {
+            total += block->json->size() + 1;
+            parts.push_back(block->json);
+        }
+    }
+
+    auto fresh = std::make_shared<Snapshot>();
+    fresh->version = version;
+    fresh->etag = etagFor(version);
+    fresh->body.reserve(total);
+    fresh->body.push_back('[');
+    for (size_t i = 0; i < parts.size(); ++i)
+    {
+        if (i)
+            fresh->body.push_back(',');
+        fresh->body.append(*parts[i]);
+    }
+    fresh->body.push_back(']');
+
+    std::shared_ptr<const Snapshot> published = std::move(fresh);
+    std::atomic_store(&snapshot_, published);
+    return published;
+}
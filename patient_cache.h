@@ -0,0 +1,87 @@
+#pragma once
+
+#include "db.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+// In-memory copy of the users table, kept as pre-serialized JSON objects so
+// that GET /users can be answered without touching SQLite.
+//
+// The writer thread updates it after each commit (write-through) and bumps a
+// version counter that doubles as the /users ETag. Rows are grouped into
+// blocks of consecutive ids, each with its own lock and a lazily rebuilt
+// JSON fragment; a reader assembling the full list only ever holds one block
+// lock at a time, so the writer waits at most for one block to serialize.
+class PatientCache
+{
+public:
+    // Another encoding of a snapshot's list: a different format, a
+    // compressed body, or both. `coding` is whatever the builder records
+    // about it (main.cpp stores the ContentCoding actually applied).
+    struct Variant
+    {
+        std::string body;
+        int coding = 0;
+    };
+
+    struct Snapshot
+    {
+        uint64_t version;
+        std::string etag;
+        std::string body;
+
+        // The variant under `key`, built by `build` the first time any
+        // request asks for it at this version and shared after that, so a
+        // whole-table response is encoded and compressed once per version
+        // rather than once per request. Returns null if `build` fails.
+        std::shared_ptr<const Variant> variant(int key, const std::function<bool(Variant &)> &build) const;
+
+    private:
+        mutable std::mutex variantsMutex_;
+        mutable std::map<int, std::shared_ptr<const Variant>> variants_;
+    };
+
+    PatientCache();
+
+    // Loads every row; call once at startup before serving requests.
+    bool load(DbConnection &conn);
+
+    void upsert(sqlite3_int64 id, std::string_view name, std::string_view phone, std::string_view disease,
+                std::string_view date);
+    void remove(sqlite3_int64 id);
+
+    uint64_t version() const { return version_.load(std::memory_order_acquire); }
+    std::string etag() const { return etagFor(version()); }
+
+    // The serialized list for the current version, rebuilt if it is stale.
+    std::shared_ptr<const Snapshot> snapshot();
+
+private:
+    static constexpr int kBlockShift = 10;
+
+    struct Block
+    {
+        std::mutex mutex;
+        std::map<sqlite3_int64, std::string> rows;
+        std::shared_ptr<const std::string> json;
+    };
+
+    std::shared_ptr<Block> blockFor(sqlite3_int64 id, bool create);
+    std::string etagFor(uint64_t version) const;
+
+    std::string epoch_;
+    std::atomic<uint64_t> version_{1};
+
+    std::mutex blocksMutex_;
+    std::map<sqlite3_int64, std::shared_ptr<Block>> blocks_;
+
+    std::mutex rebuildMutex_;
+    std::shared_ptr<const Snapshot> snapshot_;
+};
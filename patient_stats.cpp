@@ -0,0 +1,169 @@
+#include "patient_stats.h"
+
+#include "json_writer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+
+namespace
+{
+    std::string_view columnText(sqlite3_stmt *stmt, int column)
+    {
+        const char *text = reinterpret_cast<const char *>(sqlite3_column_text(stmt, column));
+        return text ? std::string_view(text, sqlite3_column_bytes(stmt, column)) : std::string_view();
+    }
+
+    void appendCounts(JsonWriter &json, std::map<std::string, int64_t>::const_iterator begin,
+                      std::map<std::string, int64_t>::const_iterator end)
+    {
+        json.raw('{');
+        for (auto it = begin; it != end; ++it)
+        {
+            if (it != begin)
+                json.raw(',');
+            json.string(it->first);
+            json.raw(':');
+            json.integer(it->second);
+        }
+        json.raw('}');
+    }
+}
+
+bool PatientStats::load(DbConnection &conn)
+{
+    Stmt stmt(conn, "SELECT id, kind, label, patients FROM user_stats");
+    if (!stmt)
+        return false;
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    groups_.clear();
+    diseases_.clear();
+    days_.clear();
+    total_ = 0;
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
+    {
+        apply(sqlite3_column_int64(stmt, 0), kindOf(columnText(stmt, 1)), std::string(columnText(stmt, 2)),
+              sqlite3_column_int64(stmt, 3));
+    }
+    if (rc != SQLITE_DONE)
+    {
+        std::cerr << "Loading patient statistics failed: " << sqlite3_errmsg(conn.handle()) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void PatientStats::render(std::string &out, std::string_view from, std::string_view to) const
+{
+    JsonWriter json(out);
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    auto undated = days_.find(std::string());
+    json.raw("{\"total\":", 9);
+    json.integer(total_);
+    json.raw(",\"undated\":", 11);
+    json.integer(undated != days_.end() ? undated->second : 0);
+    json.raw(",\"by_disease\":", 14);
+    appendCounts(json, diseases_.begin(), diseases_.end());
+
+    auto first = days_.lower_bound(std::string(from));
+    if (first != days_.end() && first->first.empty())
+        ++first;  // the undated are counted above
+    auto last = to.empty() ? days_.end() : days_.upper_bound(std::string(to));
+    if (first == days_.end() || (last != days_.end() && last->first < first->first))
+        last = first;
+    json.raw(",\"by_day\":", 10);
+    appendCounts(json, first, last);
+    json.raw('}');
+}
+
+void PatientStats::writerStarted(DbConnection &conn)
+{
+    conn_ = &conn;
+    sqlite3_update_hook(conn.handle(), &PatientStats::onUpdate, this);
+}
+
+void PatientStats::onUpdate(void *self, int, const char *, const char *table, sqlite3_int64 rowid)
+{
+    // Called for every row the writer changes; no SQL may run in here.
+    if (std::strcmp(table, "user_stats") == 0)
+        static_cast<PatientStats *>(self)->dirty_.push_back(rowid);
+}
+
+void PatientStats::batchEnded(bool)
+{
+    // Committed or not, the rows now hold what SQLite has; rows the batch
+    // created and then lost to a rollback are simply not found.
+    if (dirty_.empty() || !conn_)
+        return;
+    std::sort(dirty_.begin(), dirty_.end());
+    dirty_.erase(std::unique(dirty_.begin(), dirty_.end()), dirty_.end());
+
+    struct Read
+    {
+        sqlite3_int64 id;
+        Kind kind;
+        std::string label;
+        int64_t patients;
+    };
+    std::vector<Read> reads;
+    reads.reserve(dirty_.size());
+    {
+        Stmt stmt(*conn_, "SELECT kind, label, patients FROM user_stats WHERE id = ?");
+        if (!stmt)
+            return;
+        for (sqlite3_int64 id : dirty_)
+        {
+            sqlite3_bind_int64(stmt, 1, id);
+            Read read{id, Kind::Other, std::string(), -1};
+            if (sqlite3_step(stmt) == SQLITE_ROW)
+            {
+                read.kind = kindOf(columnText(stmt, 0));
+                read.label = std::string(columnText(stmt, 1));
+                read.patients = sqlite3_column_int64(stmt, 2);
+            }
+            sqlite3_reset(stmt);
+            reads.push_back(std::move(read));
+        }
+    }
+    dirty_.clear();
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    for (Read &read : reads)
+        apply(read.id, read.kind, std::move(read.label), read.patients);
+}
+
+PatientStats::Kind PatientStats::kindOf(std::string_view name)
+{
+    if (name == "total")
+        return Kind::Total;
+    if (name == "disease")
+        return Kind::Disease;
+    return name == "day" ? Kind::Day : Kind::Other;
+}
+
+void PatientStats::apply(sqlite3_int64 id, Kind kind, std::string label, int64_t patients)
+{
+    auto old = groups_.find(id);
+    if (old != groups_.end())
+    {
+        if (old->second.kind == Kind::Total)
+            total_ = 0;
+        else if (old->second.kind == Kind::Disease)
+            diseases_.erase(old->second.label);
+        else if (old->second.kind == Kind::Day)
+            days_.erase(old->second.label);
+        groups_.erase(old);
+    }
+    if (patients < 0)
+        return;
+    if (kind == Kind::Total)
+        total_ = patients;
+    else if (kind == Kind::Disease)
+        diseases_[label] = patients;
+    else if (kind == Kind::Day)
+        days_[label] = patients;
+    groups_.emplace(id, Group{kind, std::move(label)});
+}
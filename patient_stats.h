@@ -0,0 +1,66 @@
+#pragma once
+
+#include "db.h"
+#include "writer.h"
+
+#include <cstdint>
+#include <map>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// In-memory copy of user_stats, the patient counts behind GET /stats.
+//
+// The table's triggers keep it right in the writer's own transactions; this
+// copy follows it without repeating their logic. An update hook on the
+// writer's connection notes which user_stats rows a batch touched, and once
+// the batch has ended only those rows are read back, so keeping up costs
+// O(groups changed) per batch and a read O(groups), never O(patients).
+class PatientStats : public WriteListener
+{
+public:
+    // Reads the whole table; call once at startup.
+    bool load(DbConnection &conn);
+
+    // {"total":N,"undated":N,"by_disease":{...},"by_day":{"YYYY-MM-DD":N,...}},
+    // with by_day limited to [from, to] when those are non-empty.
+    void render(std::string &out, std::string_view from, std::string_view to) const;
+
+    void writerStarted(DbConnection &conn) override;
+    void jobBegan() override {}
+    void jobRolledBack() override {}
+    void batchEnded(bool committed) override;
+
+private:
+    enum class Kind
+    {
+        Total,
+        Disease,
+        Day,
+        Other,
+    };
+
+    struct Group
+    {
+        Kind kind;
+        std::string label;
+    };
+
+    static Kind kindOf(std::string_view name);
+    static void onUpdate(void *self, int op, const char *db, const char *table, sqlite3_int64 rowid);
+
+    // Sets the group in row `id`, or drops it when `patients` is negative.
+    void apply(sqlite3_int64 id, Kind kind, std::string label, int64_t patients);
+
+    mutable std::shared_mutex mutex_;
+    std::unordered_map<sqlite3_int64, Group> groups_;  // by user_stats id
+    int64_t total_ = 0;
+    std::map<std::string, int64_t> diseases_;
+    std::map<std::string, int64_t> days_;  // "" holds the undated
+
+    // Writer thread only.
+    DbConnection *conn_ = nullptr;
+    std::vector<sqlite3_int64> dirty_;
+};
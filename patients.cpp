@@ -0,0 +1,104 @@
+#include "patients.h"
+
+#include "change_feed.h"
+#include "patient_cache.h"
+#include "user_rows.h"
+
+namespace
+{
+    void bindPatientFields(sqlite3_stmt *stmt, const Patient &patient)
+    {
+        bindView(stmt, 1, patient.name);
+        bindView(stmt, 2, patient.phone);
+        bindView(stmt, 3, patient.disease);
+        bindView(stmt, 4, patient.date);
+        if (patient.dateIso.empty())
+            sqlite3_bind_null(stmt, 5);
+        else
+            sqlite3_bind_text(stmt, 5, patient.dateIso.c_str(), patient.dateIso.size(), SQLITE_STATIC);
+        if (patient.duration)
+            sqlite3_bind_int(stmt, 6, patient.duration);
+        else
+            sqlite3_bind_null(stmt, 6);
+    }
+
+    std::string rowJson(const Patient &patient)
+    {
+        std::string json;
+        appendUserJson(json, patient.id, patient.name, patient.phone, patient.disease, patient.date);
+        return json;
+    }
+}
+
+int insertPatient(DbConnection &conn, Patient &patient)
+{
+    Stmt stmt(conn, "INSERT INTO users (name, phone, disease, date, date_iso, duration, doctor_id) "
+                    "VALUES (?, ?, ?, ?, ?, ?, ?)");
+    if (!stmt)
+        return SQLITE_ERROR;
+    bindPatientFields(stmt, patient);
+    if (patient.doctorId)
+        sqlite3_bind_int64(stmt, 7, patient.doctorId);
+    else
+        sqlite3_bind_null(stmt, 7);
+    int rc = sqlite3_step(stmt);
+    if (rc == SQLITE_DONE)
+        patient.id = sqlite3_last_insert_rowid(conn.handle());
+    return rc;
+}
+
+int updatePatient(DbConnection &conn, const Patient &patient, int &changes)
+{
+    Stmt stmt(conn, "UPDATE users SET name=?, phone=?, disease=?, date=?, date_iso=?, duration=? WHERE id=?");
+    if (!stmt)
+        return SQLITE_ERROR;
+    bindPatientFields(stmt, patient);
+    sqlite3_bind_int64(stmt, 7, patient.id);
+    int rc = sqlite3_step(stmt);
+    changes = rc == SQLITE_DONE ? sqlite3_changes(conn.handle()) : 0;
+    return rc;
+}
+
+int deletePatient(DbConnection &conn, sqlite3_int64 id, int &changes)
+{
+    Stmt stmt(conn, "DELETE FROM users WHERE id=?");
+    if (!stmt)
+        return SQLITE_ERROR;
+    sqlite3_bind_int64(stmt, 1, id);
+    int rc = sqlite3_step(stmt);
+    changes = rc == SQLITE_DONE ? sqlite3_changes(conn.handle()) : 0;
+    return rc;
+}
+
+int assignPatient(DbConnection &conn, sqlite3_int64 id, sqlite3_int64 doctorId, int &changes)
+{
+    Stmt stmt(conn, "UPDATE users SET doctor_id=? WHERE id=?");
+    if (!stmt)
+        return SQLITE_ERROR;
+    if (doctorId)
+        sqlite3_bind_int64(stmt, 1, doctorId);
+    else
+        sqlite3_bind_null(stmt, 1);
+    sqlite3_bind_int64(stmt, 2, id);
+    int rc = sqlite3_step(stmt);
+    changes = rc == SQLITE_DONE ? sqlite3_changes(conn.handle()) : 0;
+    return rc;
+}
+
+void PatientMirror::inserted(const Patient &patient)
+{
+    cache_.upsert(patient.id, patient.name, patient.phone, patient.disease, patient.date);
+    feed_.publish("insert", patient.id, rowJson(patient));
+}
+
+void PatientMirror::updated(const Patient &patient)
+{
+    cache_.upsert(patient.id, patient.name, patient.phone, patient.disease, patient.date);
+    feed_.publish("update", patient.id, rowJson(patient));
+}
+
+void PatientMirror::deleted(sqlite3_int64 id)
+{
+    cache_.remove(id);
+    feed_.publish("delete", id, std::string());
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "db.h"
+
+#include <string>
+#include <string_view>
+
+class ChangeFeed;
+class PatientCache;
+
+// A users row as the mutation paths see it. The text fields are views into
+// the request body or the request's arena (see JsonView and BulkReader), so
+// filling one from a request copies nothing; a Patient must not outlive the
+// handler that parsed it.
+struct Patient
+{
+    sqlite3_int64 id = 0;
+    std::string_view name;
+    std::string_view phone;
+    std::string_view disease;
+    std::string_view date;
+    std::string dateIso;  // normalized date, empty if `date` is not a date
+    sqlite3_int64 doctorId = 0;  // assigned doctor, 0 for none; set on insert only
+    int duration = 0;            // appointment length in minutes, 0 for the default
+};
+
+// The users mutations shared by /add, /edit, /delete, /users/bulk and
+// /batch. They run on the writer's connection inside a writer job, through
+// the connection's cached statements, and return the sqlite3_step result
+// (SQLITE_DONE on success).
+int insertPatient(DbConnection &conn, Patient &patient);
+int updatePatient(DbConnection &conn, const Patient &patient, int &changes);
+int deletePatient(DbConnection &conn, sqlite3_int64 id, int &changes);
+
+// Assigns a patient to `doctorId`, or unassigns it when that is 0. Fails with
+// SQLITE_CONSTRAINT if the doctor does not exist.
+int assignPatient(DbConnection &conn, sqlite3_int64 id, sqlite3_int64 doctorId, int &changes);
+
+// Mirrors committed users changes into the in-memory views that serve reads
+// without SQLite. Only called from writer commit hooks, so changes arrive
+// one at a time and in commit order.
+class PatientMirror
+{
+public:
+    PatientMirror(PatientCache &cache, ChangeFeed &feed) : cache_(cache), feed_(feed) {}
+
+    void inserted(const Patient &patient);
+    void updated(const Patient &patient);
+    void deleted(sqlite3_int64 id);
+
+private:
+    PatientCache &cache_;
+    ChangeFeed &feed_;
+};
@@ -0,0 +1,221 @@
+#include "schema.h"
+
+#include "dates.h"
+
+#include <iostream>
+#include <string>
+
+namespace
+{
+    // Fills users.date_iso from the free-form date of every existing row,
+    // then indexes it (building the index after the fill is cheaper).
+    bool normalizeExistingDates(DbConnection &db)
+    {
+        Stmt select(db, "SELECT id, date FROM users");
+        Stmt update(db, "UPDATE users SET date_iso = ? WHERE id = ?");
+        if (!select || !update)
+            return false;
+
+        std::string iso;
+        while (sqlite3_step(select) == SQLITE_ROW)
+        {
+            const char *date = reinterpret_cast<const char *>(sqlite3_column_text(select, 1));
+            if (!date || !normalizeDate(date, iso))
+                continue;
+            sqlite3_bind_text(update, 1, iso.c_str(), -1, SQLITE_STATIC);
+            sqlite3_bind_int64(update, 2, sqlite3_column_int64(select, 0));
+            if (sqlite3_step(update) != SQLITE_DONE)
+                return false;
+            sqlite3_reset(update);
+        }
+        return db.exec("CREATE INDEX users_date_iso ON users (date_iso);");
+    }
+
+    // db-init.sh creates doctors without patient_count; add it if missing,
+    // then count the patients already assigned.
+    bool addDoctorCounts(DbConnection &db)
+    {
+        bool hasCount = false;
+        {
+            Stmt columns(db, "SELECT 1 FROM pragma_table_info('doctors') WHERE name = 'patient_count'");
+            if (!columns)
+                return false;
+            hasCount = sqlite3_step(columns) == SQLITE_ROW;
+        }
+        if (!hasCount && !db.exec("ALTER TABLE doctors ADD COLUMN patient_count INTEGER NOT NULL DEFAULT 0;"))
+            return false;
+        return db.exec("UPDATE doctors SET patient_count = "
+                       "(SELECT count(*) FROM users WHERE doctor_id = doctors.id);");
+    }
+
+    struct Migration
+    {
+        int version;
+        const char *sql;
+        // Optional data migration run after `sql`, inside the same transaction.
+        bool (*run)(DbConnection &db);
+    };
+
+    const Migration kMigrations[] = {
+        // The original tables, plus the default admin account when there is none.
+        {1,
+         "CREATE TABLE IF NOT EXISTS users ("
+         "id INTEGER PRIMARY KEY AUTOINCREMENT, "
+         "name TEXT NOT NULL, "
+         "phone TEXT NOT NULL, "
+         "disease TEXT NOT NULL, "
+         "date TEXT NOT NULL);"
+         "CREATE TABLE IF NOT EXISTS accounts ("
+         "id INTEGER PRIMARY KEY AUTOINCREMENT, "
+         "username TEXT NOT NULL UNIQUE, "
+         "password TEXT NOT NULL);"
+         "INSERT INTO accounts (username, password) "
+         "SELECT 'admin', '1234' WHERE NOT EXISTS (SELECT 1 FROM accounts);",
+         nullptr},
+
+        // Full-text index over name, disease and phone for /users/search. It is
+        // an external-content table, so it stores only the index; the triggers
+        // keep it in step with users inside the writer's own transaction.
+        {2,
+         "CREATE VIRTUAL TABLE users_fts USING fts5("
+         "name, disease, phone, content='users', content_rowid='id', "
+         "tokenize='unicode61 remove_diacritics 2', prefix='2 3');"
+         "CREATE TRIGGER users_fts_insert AFTER INSERT ON users BEGIN "
+         "INSERT INTO users_fts (rowid, name, disease, phone) VALUES (new.id, new.name, new.disease, new.phone); "
+         "END;"
+         "CREATE TRIGGER users_fts_delete AFTER DELETE ON users BEGIN "
+         "INSERT INTO users_fts (users_fts, rowid, name, disease, phone) "
+         "VALUES ('delete', old.id, old.name, old.disease, old.phone); "
+         "END;"
+         "CREATE TRIGGER users_fts_update AFTER UPDATE OF name, disease, phone ON users BEGIN "
+         "INSERT INTO users_fts (users_fts, rowid, name, disease, phone) "
+         "VALUES ('delete', old.id, old.name, old.disease, old.phone); "
+         "INSERT INTO users_fts (rowid, name, disease, phone) VALUES (new.id, new.name, new.disease, new.phone); "
+         "END;"
+         "INSERT INTO users_fts (users_fts) VALUES ('rebuild');",
+         nullptr},
+
+        // Sortable copy of the appointment date ("YYYY-MM-DD[THH:MM]", NULL
+        // when the entered text is not a date), indexed for /appointments.
+        {3,
+         "ALTER TABLE users ADD COLUMN date_iso TEXT;",
+         normalizeExistingDates},
+
+        // Doctors (the table db-init.sh declares) and patient assignment.
+        // users_doctor covers GET /doctors/<id>/patients, so a doctor's list
+        // is one index range; patient_count is kept by triggers in the same
+        // transaction as every insert, delete and reassignment.
+        {4,
+         "CREATE TABLE IF NOT EXISTS doctors ("
+         "id INTEGER PRIMARY KEY AUTOINCREMENT, "
+         "name TEXT NOT NULL, "
+         "specialty TEXT);"
+         "ALTER TABLE users ADD COLUMN doctor_id INTEGER REFERENCES doctors (id) ON DELETE SET NULL;"
+         "CREATE INDEX users_doctor ON users (doctor_id, id, name, phone, disease, date) "
+         "WHERE doctor_id IS NOT NULL;"
+         "CREATE TRIGGER users_doctor_insert AFTER INSERT ON users WHEN new.doctor_id IS NOT NULL BEGIN "
+         "UPDATE doctors SET patient_count = patient_count + 1 WHERE id = new.doctor_id; "
+         "END;"
+         "CREATE TRIGGER users_doctor_delete AFTER DELETE ON users WHEN old.doctor_id IS NOT NULL BEGIN "
+         "UPDATE doctors SET patient_count = patient_count - 1 WHERE id = old.doctor_id; "
+         "END;"
+         "CREATE TRIGGER users_doctor_update AFTER UPDATE OF doctor_id ON users "
+         "WHEN old.doctor_id IS NOT new.doctor_id BEGIN "
+         "UPDATE doctors SET patient_count = patient_count - 1 WHERE id = old.doctor_id; "
+         "UPDATE doctors SET patient_count = patient_count + 1 WHERE id = new.doctor_id; "
+         "END;",
+         addDoctorCounts},
+
+        // Appointment length in minutes, NULL for the configured default; with
+        // date_iso it places the row in the in-memory slot index.
+        {5,
+         "ALTER TABLE users ADD COLUMN duration INTEGER;",
+         nullptr},
+
+        // Patient counts for GET /stats: the total, per disease and per
+        // appointment day ('' for dates that did not parse). Triggers keep
+        // them in the same transaction as every users change, so reading them
+        // never scans users; groups other than the total go once empty.
+        {6,
+         "CREATE TABLE user_stats ("
+         "id INTEGER PRIMARY KEY, "
+         "kind TEXT NOT NULL, "
+         "label TEXT NOT NULL, "
+         "patients INTEGER NOT NULL, "
+         "UNIQUE (kind, label));"
+         "CREATE TRIGGER users_stats_insert AFTER INSERT ON users BEGIN "
+         "UPDATE user_stats SET patients = patients + 1 WHERE kind = 'total'; "
+         "INSERT INTO user_stats (kind, label, patients) VALUES ('disease', new.disease, 1) "
+         "ON CONFLICT (kind, label) DO UPDATE SET patients = patients + 1; "
+         "INSERT INTO user_stats (kind, label, patients) VALUES ('day', coalesce(substr(new.date_iso, 1, 10), ''), 1) "
+         "ON CONFLICT (kind, label) DO UPDATE SET patients = patients + 1; "
+         "END;"
+         "CREATE TRIGGER users_stats_delete AFTER DELETE ON users BEGIN "
+         "UPDATE user_stats SET patients = patients - 1 WHERE kind = 'total'; "
+         "UPDATE user_stats SET patients = patients - 1 WHERE kind = 'disease' AND label = old.disease; "
+         "DELETE FROM user_stats WHERE kind = 'disease' AND label = old.disease AND patients <= 0; "
+         "UPDATE user_stats SET patients = patients - 1 "
+         "WHERE kind = 'day' AND label = coalesce(substr(old.date_iso, 1, 10), ''); "
+         "DELETE FROM user_stats "
+         "WHERE kind = 'day' AND label = coalesce(substr(old.date_iso, 1, 10), '') AND patients <= 0; "
+         "END;"
+         "CREATE TRIGGER users_stats_disease AFTER UPDATE OF disease ON users "
+         "WHEN old.disease IS NOT new.disease BEGIN "
+         "UPDATE user_stats SET patients = patients - 1 WHERE kind = 'disease' AND label = old.disease; "
+         "DELETE FROM user_stats WHERE kind = 'disease' AND label = old.disease AND patients <= 0; "
+         "INSERT INTO user_stats (kind, label, patients) VALUES ('disease', new.disease, 1) "
+         "ON CONFLICT (kind, label) DO UPDATE SET patients = patients + 1; "
+         "END;"
+         "CREATE TRIGGER users_stats_day AFTER UPDATE OF date_iso ON users "
+         "WHEN coalesce(substr(old.date_iso, 1, 10), '') IS NOT coalesce(substr(new.date_iso, 1, 10), '') BEGIN "
+         "UPDATE user_stats SET patients = patients - 1 "
+         "WHERE kind = 'day' AND label = coalesce(substr(old.date_iso, 1, 10), ''); "
+         "DELETE FROM user_stats "
+         "WHERE kind = 'day' AND label = coalesce(substr(old.date_iso, 1, 10), '') AND patients <= 0; "
+         "INSERT INTO user_stats (kind, label, patients) VALUES ('day', coalesce(substr(new.date_iso, 1, 10), ''), 1) "
+         "ON CONFLICT (kind, label) DO UPDATE SET patients = patients + 1; "
+         "END;",
+         rebuildUserStats},
+    };
+
+    int userVersion(DbConnection &db)
+    {
+        Stmt stmt(db, "PRAGMA user_version;");
+        return stmt && sqlite3_step(stmt) == SQLITE_ROW ? sqlite3_column_int(stmt, 0) : -1;
+    }
+}
+
+bool rebuildUserStats(DbConnection &db)
+{
+    return db.exec("DELETE FROM user_stats;"
+                   "INSERT INTO user_stats (kind, label, patients) SELECT 'total', '', count(*) FROM users;"
+                   "INSERT INTO user_stats (kind, label, patients) "
+                   "SELECT 'disease', disease, count(*) FROM users GROUP BY disease;"
+                   "INSERT INTO user_stats (kind, label, patients) "
+                   "SELECT 'day', coalesce(substr(date_iso, 1, 10), ''), count(*) FROM users GROUP BY 2;");
+}
+
+bool migrateSchema(DbConnection &db)
+{
+    int current = userVersion(db);
+    if (current < 0)
+        return false;
+
+    for (const Migration &migration : kMigrations)
+    {
+        if (migration.version <= current)
+            continue;
+
+        std::string setVersion = "PRAGMA user_version = " + std::to_string(migration.version) + ";";
+        bool ok = db.exec("BEGIN IMMEDIATE;") && db.exec(migration.sql) &&
+                  (!migration.run || migration.run(db)) && db.exec(setVersion.c_str()) && db.exec("COMMIT;");
+        if (!ok)
+        {
+            std::cerr << "Schema migration to version " << migration.version << " failed" << std::endl;
+            db.exec("ROLLBACK;");
+            return false;
+        }
+        std::cout << "Schema migrated to version " << migration.version << std::endl;
+    }
+    return true;
+}
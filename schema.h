@@ -0,0 +1,12 @@
+#pragma once
+
+#include "db.h"
+
+// Brings the database up to the current schema. Each migration runs once, in
+// its own transaction, and is recorded in PRAGMA user_version, so this is
+// cheap on an up-to-date file and safe to run at every startup.
+bool migrateSchema(DbConnection &db);
+
+// Recounts user_stats from users, for when its triggers were bypassed (see
+// bench/hms_datagen.cpp).
+bool rebuildUserStats(DbConnection &db);
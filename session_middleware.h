@@ -0,0 +1,30 @@
+#pragma once
+
+#include "crow.h"
+#include "session_store.h"
+
+#include <string>
+
+// Re-sends the session cookie with a fresh Max-Age while the session slides
+// on the server; without it the browser would drop the cookie a fixed TTL
+// after login however active the user was. Handlers that validate a session
+// name its token in the context when SessionStore asks for a renewal.
+struct SessionMiddleware
+{
+    SessionStore *sessions = nullptr;  // set before the server starts
+
+    struct context
+    {
+        std::string renewToken;
+    };
+
+    void before_handle(crow::request &, crow::response &, context &) {}
+
+    void after_handle(crow::request &, crow::response &res, context &ctx)
+    {
+        // A response that sets the cookie itself (login, logout) wins.
+        if (!sessions || ctx.renewToken.empty() || !res.get_header_value("Set-Cookie").empty())
+            return;
+        res.set_header("Set-Cookie", sessionSetCookie(ctx.renewToken, sessions->ttl()));
+    }
+};
@@ -0,0 +1,156 @@
+#include "session_store.h"
+
+#include <functional>
+#include <random>
+
+namespace
+{
+    const char kCookieName[] = "hms_session";
+
+    // 256 bits from the OS entropy source, hex encoded.
+    std::string randomToken()
+    {
+        static const char hex[] = "0123456789abcdef";
+        thread_local std::random_device device;
+        std::string token;
+        token.reserve(64);
+        for (int i = 0; i < 8; ++i)
+        {
+            uint32_t word = device();
+            for (int nibble = 0; nibble < 8; ++nibble)
+            {
+                token.push_back(hex[word & 0xf]);
+                word >>= 4;
+            }
+        }
+        return token;
+    }
+}
+
+SessionStore::SessionStore(std::chrono::seconds ttl, size_t shards) : ttl_(ttl)
+{
+    shards_.reserve(shards);
+    for (size_t i = 0; i < shards; ++i)
+        shards_.push_back(std::make_unique<Shard>());
+}
+
+SessionStore::Shard &SessionStore::shardFor(const std::string &token)
+{
+    return *shards_[std::hash<std::string>()(token) % shards_.size()];
+}
+
+std::string SessionStore::create(const std::string &username)
+{
+    std::string token = randomToken();
+    Shard &shard = shardFor(token);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto now = Clock::now();
+    shard.sessions[token] = Session{username, now + ttl_, now};
+    return token;
+}
+
+bool SessionStore::validate(const std::string &token, std::string *username, bool *renewCookie)
+{
+    if (token.empty())
+        return false;
+
+    Shard &shard = shardFor(token);
+    auto now = Clock::now();
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.sessions.find(token);
+    if (it == shard.sessions.end())
+        return false;
+    if (it->second.expires <= now)
+    {
+        shard.sessions.erase(it);
+        return false;
+    }
+    it->second.expires = now + ttl_;
+    if (username)
+        *username = it->second.username;
+    // Re-sending Set-Cookie on every response would be wasted bytes; an
+    // eighth of the TTL keeps cookie and session expiry close enough.
+    if (renewCookie && now - it->second.cookieSent >= ttl_ / 8)
+    {
+        it->second.cookieSent = now;
+        *renewCookie = true;
+    }
+    return true;
+}
+
+void SessionStore::revoke(const std::string &token)
+{
+    Shard &shard = shardFor(token);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.sessions.erase(token);
+}
+
+void SessionStore::sweep()
+{
+    for (auto &shard : shards_)
+    {
+        auto now = Clock::now();
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        for (auto it = shard->sessions.begin(); it != shard->sessions.end();)
+        {
+            if (it->second.expires <= now)
+                it = shard->sessions.erase(it);
+            else
+                ++it;
+        }
+    }
+}
+
+void SessionStore::startSweeper(std::chrono::seconds interval)
+{
+    std::lock_guard<std::mutex> lock(sweeperMutex_);
+    if (sweeping_)
+        return;
+    sweeping_ = true;
+    sweeper_ = std::thread([this, interval] {
+        std::unique_lock<std::mutex> lock(sweeperMutex_);
+        while (!sweeperWake_.wait_for(lock, interval, [this] { return !sweeping_; }))
+        {
+            lock.unlock();
+            sweep();
+            lock.lock();
+        }
+    });
+}
+
+void SessionStore::stopSweeper()
+{
+    {
+        std::lock_guard<std::mutex> lock(sweeperMutex_);
+        if (!sweeping_)
+            return;
+        sweeping_ = false;
+    }
+    sweeperWake_.notify_one();
+    sweeper_.join();
+}
+
+std::string sessionCookie(const std::string &cookieHeader)
+{
+    const size_t nameLen = sizeof(kCookieName) - 1;
+    size_t pos = 0;
+    while (pos < cookieHeader.size())
+    {
+        while (pos < cookieHeader.size() && (cookieHeader[pos] == ' ' || cookieHeader[pos] == ';'))
+            ++pos;
+        size_t end = cookieHeader.find(';', pos);
+        if (end == std::string::npos)
+            end = cookieHeader.size();
+        if (cookieHeader.compare(pos, nameLen, kCookieName) == 0 && pos + nameLen < end &&
+            cookieHeader[pos + nameLen] == '=')
+            return cookieHeader.substr(pos + nameLen + 1, end - pos - nameLen - 1);
+        pos = end;
+    }
+    return {};
+}
+
+std::string sessionSetCookie(const std::string &token, std::chrono::seconds maxAge)
+{
+    return std::string(kCookieName) + "=" + token + "; Path=/; HttpOnly; SameSite=Strict; Max-Age=" +
+           std::to_string(maxAge.count());
+}
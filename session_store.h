@@ -0,0 +1,79 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Login sessions keyed by an unguessable random token (sent as a cookie).
+//
+// Sessions are spread over independently locked shards chosen by the token
+// itself, so a lookup is one hash probe under one shard's mutex and requests
+// for different sessions never contend on a shared lock. Each successful
+// lookup slides the expiry forward; a background thread sweeps out sessions
+// that have been idle longer than the TTL. The browser's cookie carries a
+// Max-Age of its own, so callers re-send it as the session slides (see
+// SessionMiddleware); it then never expires more than an eighth of the TTL
+// before the session does.
+class SessionStore
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit SessionStore(std::chrono::seconds ttl, size_t shards = 64);
+    ~SessionStore() { stopSweeper(); }
+
+    SessionStore(const SessionStore &) = delete;
+    SessionStore &operator=(const SessionStore &) = delete;
+
+    // Starts a session for `username` and returns its token.
+    std::string create(const std::string &username);
+
+    // True if `token` names a live session; refreshes its expiry and, if
+    // `username` is given, reports who it belongs to. `renewCookie`, if
+    // given, is set when the cookie was last sent an eighth of the TTL ago or
+    // more; the caller must then send it again with a Max-Age of ttl().
+    bool validate(const std::string &token, std::string *username = nullptr, bool *renewCookie = nullptr);
+
+    void revoke(const std::string &token);
+
+    void startSweeper(std::chrono::seconds interval = std::chrono::seconds(60));
+    void stopSweeper();
+
+    std::chrono::seconds ttl() const { return ttl_; }
+
+private:
+    struct Session
+    {
+        std::string username;
+        Clock::time_point expires;
+        Clock::time_point cookieSent;  // when the browser last got a fresh Max-Age
+    };
+
+    struct Shard
+    {
+        std::mutex mutex;
+        std::unordered_map<std::string, Session> sessions;
+    };
+
+    Shard &shardFor(const std::string &token);
+    void sweep();
+
+    std::chrono::seconds ttl_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+
+    std::thread sweeper_;
+    std::mutex sweeperMutex_;
+    std::condition_variable sweeperWake_;
+    bool sweeping_ = false;
+};
+
+// Value of the session cookie in a Cookie header, or an empty string.
+std::string sessionCookie(const std::string &cookieHeader);
+
+// Set-Cookie value that stores `token` for `maxAge` (0 clears the cookie).
+std::string sessionSetCookie(const std::string &token, std::chrono::seconds maxAge);
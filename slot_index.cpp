@@ -0,0 +1,273 @@
+#include "slot_index.h"
+
+#include "dates.h"
+
+#include <algorithm>
+#include <iostream>
+#include <mutex>
+
+namespace
+{
+    int64_t floorDiv(int64_t value, int64_t divisor)
+    {
+        return value >= 0 ? value / divisor : (value - divisor + 1) / divisor;
+    }
+}
+
+bool SlotIndex::load(DbConnection &conn)
+{
+    Stmt stmt(conn, "SELECT id, doctor_id, date_iso, duration FROM users WHERE length(date_iso) = 16");
+    if (!stmt)
+        return false;
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    bookings_.clear();
+    days_.clear();
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
+    {
+        Patient patient;
+        patient.id = sqlite3_column_int64(stmt, 0);
+        const char *iso = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 2));
+        patient.dateIso = iso ? iso : "";
+        patient.duration = sqlite3_column_int(stmt, 3);
+        Booking booking;
+        if (bookingFor(patient, sqlite3_column_int64(stmt, 1), booking))
+            insert(patient.id, booking);
+    }
+    if (rc != SQLITE_DONE)
+    {
+        std::cerr << "Loading appointment slots failed: " << sqlite3_errmsg(conn.handle()) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool SlotIndex::bookingFor(const Patient &patient, sqlite3_int64 doctorId, Booking &booking) const
+{
+    int64_t start;
+    if (!isoMinutes(patient.dateIso, start))
+        return false;
+    int minutes = patient.duration > 0 ? patient.duration : defaultMinutes_;
+    int64_t minuteOfDay = start - floorDiv(start, 1440) * 1440;
+    int64_t end = std::min<int64_t>(minuteOfDay + minutes, 1440);
+    booking.doctorId = doctorId;
+    booking.day = floorDiv(start, 1440);
+    booking.unit = static_cast<uint16_t>(minuteOfDay / kUnitMinutes);
+    int64_t endUnit = (end + kUnitMinutes - 1) / kUnitMinutes;
+    booking.units = static_cast<uint16_t>(std::max<int64_t>(1, endUnit - booking.unit));
+    return true;
+}
+
+bool SlotIndex::isFree(const Booking &booking, sqlite3_int64 ignoreId) const
+{
+    auto day = days_.find(DayKey(booking.doctorId, booking.day));
+    if (day == days_.end())
+        return true;
+    bool clear = true;
+    for (int unit = booking.unit; unit < booking.unit + booking.units && clear; ++unit)
+        clear = !day->second.busy[unit];
+    if (clear || !ignoreId)
+        return clear;
+
+    // Busy, perhaps only with the patient's own booking, as when an
+    // appointment moves by a few minutes: check the bookings themselves.
+    for (const Entry &entry : day->second.entries)
+        if (entry.id != ignoreId && entry.unit < booking.unit + booking.units &&
+            booking.unit < entry.unit + entry.units)
+            return false;
+    return true;
+}
+
+bool SlotIndex::available(const Patient &patient, sqlite3_int64 doctorId) const
+{
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    Booking booking;
+    return !bookingFor(patient, doctorId, booking) || isFree(booking, patient.id);
+}
+
+bool SlotIndex::book(const Patient &patient, sqlite3_int64 doctorId)
+{
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    Booking booking;
+    if (!bookingFor(patient, doctorId, booking))
+    {
+        place(patient.id, nullptr);
+        return true;
+    }
+    if (!isFree(booking, patient.id))
+        return false;
+    place(patient.id, &booking);
+    return true;
+}
+
+bool SlotIndex::reassign(sqlite3_int64 id, sqlite3_int64 doctorId)
+{
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    auto it = bookings_.find(id);
+    if (it == bookings_.end() || it->second.doctorId == doctorId)
+        return true;
+    Booking booking = it->second;
+    booking.doctorId = doctorId;
+    if (!isFree(booking, id))
+        return false;
+    place(id, &booking);
+    return true;
+}
+
+void SlotIndex::cancel(sqlite3_int64 id)
+{
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    place(id, nullptr);
+}
+
+void SlotIndex::doctorDeleted(sqlite3_int64 doctorId)
+{
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    std::vector<sqlite3_int64> moved;
+    for (auto day = days_.lower_bound(DayKey(doctorId, INT64_MIN));
+         day != days_.end() && day->first.first == doctorId; ++day)
+        for (const Entry &entry : day->second.entries)
+            moved.push_back(entry.id);
+    for (sqlite3_int64 id : moved)
+    {
+        Booking booking = bookings_[id];
+        booking.doctorId = 0;
+        place(id, &booking);
+    }
+}
+
+bool SlotIndex::doctorOf(sqlite3_int64 id, sqlite3_int64 &doctorId) const
+{
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    auto it = bookings_.find(id);
+    if (it == bookings_.end())
+        return false;
+    doctorId = it->second.doctorId;
+    return true;
+}
+
+bool SlotIndex::nextFree(sqlite3_int64 doctorId, int64_t after, int minutes, int opensAt, int closesAt,
+                         int64_t &start) const
+{
+    int units = (minutes + kUnitMinutes - 1) / kUnitMinutes;
+    int firstUnit = (opensAt + kUnitMinutes - 1) / kUnitMinutes;
+    int lastUnit = closesAt / kUnitMinutes;  // exclusive
+    if (units <= 0 || units > lastUnit - firstUnit)
+        return false;
+
+    int64_t day = floorDiv(after, 1440);
+    int64_t minuteOfDay = after - day * 1440;
+    int unit = static_cast<int>((minuteOfDay + kUnitMinutes - 1) / kUnitMinutes);
+
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    auto it = days_.lower_bound(DayKey(doctorId, day));
+    for (int searched = 0; searched < kSearchDays; ++searched, ++day, unit = 0)
+    {
+        while (it != days_.end() && it->first.first == doctorId && it->first.second < day)
+            ++it;
+        bool booked = it != days_.end() && it->first == DayKey(doctorId, day);
+        int candidate = std::max(unit, firstUnit);
+        while (candidate + units <= lastUnit)
+        {
+            // Jump past the last busy unit in the window, if there is one.
+            int busy = -1;
+            if (booked)
+                for (int u = candidate + units - 1; u >= candidate; --u)
+                    if (it->second.busy[u])
+                    {
+                        busy = u;
+                        break;
+                    }
+            if (busy < 0)
+            {
+                start = day * 1440 + candidate * kUnitMinutes;
+                return true;
+            }
+            candidate = busy + 1;
+        }
+    }
+    return false;
+}
+
+size_t SlotIndex::size() const
+{
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return bookings_.size();
+}
+
+void SlotIndex::place(sqlite3_int64 id, const Booking *booking)
+{
+    auto old = bookings_.find(id);
+    if (old == bookings_.end() && !booking)
+        return;
+    journal_.push_back(Undo{id, old != bookings_.end(), old != bookings_.end() ? old->second : Booking()});
+    erase(id);
+    if (booking)
+        insert(id, *booking);
+}
+
+void SlotIndex::insert(sqlite3_int64 id, const Booking &booking)
+{
+    bookings_[id] = booking;
+    Day &day = days_[DayKey(booking.doctorId, booking.day)];
+    day.entries.push_back(Entry{id, booking.unit, booking.units});
+    for (int unit = booking.unit; unit < booking.unit + booking.units; ++unit)
+        day.busy.set(unit);
+}
+
+void SlotIndex::erase(sqlite3_int64 id)
+{
+    auto it = bookings_.find(id);
+    if (it == bookings_.end())
+        return;
+    auto day = days_.find(DayKey(it->second.doctorId, it->second.day));
+    bookings_.erase(it);
+    if (day == days_.end())
+        return;
+
+    // Rebuild the bitmap from what is left, since old data may overlap.
+    std::vector<Entry> &entries = day->second.entries;
+    entries.erase(std::remove_if(entries.begin(), entries.end(), [id](const Entry &entry) { return entry.id == id; }),
+                  entries.end());
+    if (entries.empty())
+    {
+        days_.erase(day);
+        return;
+    }
+    day->second.busy.reset();
+    for (const Entry &entry : entries)
+        for (int unit = entry.unit; unit < entry.unit + entry.units; ++unit)
+            day->second.busy.set(unit);
+}
+
+void SlotIndex::undoTo(size_t mark)
+{
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    while (journal_.size() > mark)
+    {
+        Undo undo = journal_.back();
+        journal_.pop_back();
+        erase(undo.id);
+        if (undo.had)
+            insert(undo.id, undo.booking);
+    }
+}
+
+void SlotIndex::jobBegan()
+{
+    jobMark_ = journal_.size();
+}
+
+void SlotIndex::jobRolledBack()
+{
+    undoTo(jobMark_);
+}
+
+void SlotIndex::batchEnded(bool committed)
+{
+    if (!committed)
+        undoTo(0);
+    journal_.clear();
+    jobMark_ = 0;
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include "db.h"
+#include "patients.h"
+#include "writer.h"
+
+#include <bitset>
+#include <cstdint>
+#include <map>
+#include <shared_mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Appointment bookings per doctor and day, in memory, so the front desk's
+// conflict checks and free-slot searches never touch SQLite.
+//
+// A patient whose date has a time of day books its doctor (doctor 0 being
+// the calendar of unassigned patients) from that time for its duration, in
+// kUnitMinutes steps; bookings end at midnight at the latest. Each doctor's
+// day is a bitmap of busy units plus the bookings it was built from, found
+// by a map lookup, so a conflict check is O(log n) and a free-slot search
+// skips empty days without looking at them.
+//
+// Writer jobs change the index directly, after their SQL succeeds, so later
+// jobs in the same batch see the booking. Every change is journaled and
+// undone if the job's savepoint or the batch's transaction rolls back; see
+// WriteListener. Readers take a shared lock.
+class SlotIndex : public WriteListener
+{
+public:
+    static constexpr int kUnitMinutes = 5;
+    static constexpr int kUnitsPerDay = 24 * 60 / kUnitMinutes;
+    static constexpr int kSearchDays = 366;
+
+    // `defaultMinutes` is the length of a booking whose duration is unset.
+    explicit SlotIndex(int defaultMinutes) : defaultMinutes_(defaultMinutes) {}
+
+    // Books every timed appointment in users; call once at startup. Existing
+    // overlaps are kept as they are.
+    bool load(DbConnection &conn);
+
+    // Whether `patient`'s appointment fits `doctorId`'s calendar, its own
+    // current booking aside. Untimed dates always fit.
+    bool available(const Patient &patient, sqlite3_int64 doctorId) const;
+
+    // The mutators run on the writer thread, inside a job.
+
+    // Books `patient`'s appointment with `doctorId`, replacing the booking it
+    // held. Returns false, and changes nothing, if that overlaps another
+    // booking of the same doctor. A date without a time drops the booking.
+    bool book(const Patient &patient, sqlite3_int64 doctorId);
+
+    // Moves a patient's booking to another doctor; false on a conflict there.
+    bool reassign(sqlite3_int64 id, sqlite3_int64 doctorId);
+
+    void cancel(sqlite3_int64 id);
+
+    // A deleted doctor's patients become unassigned: their bookings move to
+    // doctor 0 whether or not they overlap what is there.
+    void doctorDeleted(sqlite3_int64 doctorId);
+
+    // The doctor a booked patient is with; false if it holds no booking.
+    bool doctorOf(sqlite3_int64 id, sqlite3_int64 &doctorId) const;
+
+    // Earliest start at or after `after` (minutes, see isoMinutes) when
+    // `doctorId` is free for `minutes`, within opening hours given as
+    // minutes past midnight. Looks up to kSearchDays ahead.
+    bool nextFree(sqlite3_int64 doctorId, int64_t after, int minutes, int opensAt, int closesAt,
+                  int64_t &start) const;
+
+    size_t size() const;
+
+    void jobBegan() override;
+    void jobRolledBack() override;
+    void batchEnded(bool committed) override;
+
+private:
+    struct Booking
+    {
+        sqlite3_int64 doctorId = 0;
+        int64_t day = 0;  // days since 1970-01-01
+        uint16_t unit = 0;
+        uint16_t units = 0;
+    };
+
+    struct Entry
+    {
+        sqlite3_int64 id;
+        uint16_t unit;
+        uint16_t units;
+    };
+
+    struct Day
+    {
+        std::bitset<kUnitsPerDay> busy;
+        std::vector<Entry> entries;
+    };
+
+    // A patient's booking before a change, to put back on rollback.
+    struct Undo
+    {
+        sqlite3_int64 id;
+        bool had;
+        Booking booking;
+    };
+
+    using DayKey = std::pair<sqlite3_int64, int64_t>;
+
+    bool bookingFor(const Patient &patient, sqlite3_int64 doctorId, Booking &booking) const;
+    bool isFree(const Booking &booking, sqlite3_int64 ignoreId) const;
+    // Sets or clears `id`'s booking, journaling the old one.
+    void place(sqlite3_int64 id, const Booking *booking);
+    void insert(sqlite3_int64 id, const Booking &booking);
+    void erase(sqlite3_int64 id);
+    void undoTo(size_t mark);
+
+    int defaultMinutes_;
+    mutable std::shared_mutex mutex_;
+    std::unordered_map<sqlite3_int64, Booking> bookings_;
+    std::map<DayKey, Day> days_;
+
+    // Writer thread only.
+    std::vector<Undo> journal_;
+    size_t jobMark_ = 0;
+};
@@ -0,0 +1,224 @@
+#include "spool.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    // How long a finished spool file keeps its name. Crow opens it right
+    // after the handler returns; after that the open descriptor keeps the
+    // data readable, so the name can go.
+    constexpr auto kSpoolMaxAge = std::chrono::seconds(10);
+
+    std::atomic<uint64_t> spoolLimit{1ull << 30};
+
+    // Bytes held by this process's spool files: reserved as they are
+    // written, given back when a file is removed. Every writer reserves
+    // against the same counter, so concurrent bodies cannot overshoot the
+    // limit between them.
+    std::atomic<uint64_t> spoolUsed{0};
+
+    // Finished files, oldest first, with the bytes they hold. Crow reads
+    // them after the handler returns, so they keep their names (and their
+    // bytes stay reserved) until they are kSpoolMaxAge old.
+    struct Finished
+    {
+        std::string path;
+        uint64_t bytes;
+        std::chrono::steady_clock::time_point at;
+    };
+    std::mutex finishedMutex;
+    std::deque<Finished> finished;
+
+    bool reserve(uint64_t bytes)
+    {
+        uint64_t limit = spoolLimit.load(std::memory_order_relaxed);
+        uint64_t used = spoolUsed.load(std::memory_order_relaxed);
+        do
+        {
+            if (used > limit || bytes > limit - used)
+                return false;
+        } while (!spoolUsed.compare_exchange_weak(used, used + bytes, std::memory_order_relaxed));
+        return true;
+    }
+
+    void unreserve(uint64_t bytes)
+    {
+        spoolUsed.fetch_sub(bytes, std::memory_order_relaxed);
+    }
+
+    const fs::path &spoolDir()
+    {
+        static const fs::path dir = [] {
+            std::error_code ec;
+            fs::path path = fs::temp_directory_path(ec) / "hms-spool";
+            fs::create_directories(path, ec);
+            return path;
+        }();
+        return dir;
+    }
+
+    // Removes this process's finished files once they are kSpoolMaxAge old,
+    // and whatever an earlier process left behind once it is as old. Runs on
+    // every open(); the directory only ever holds the few bodies in flight.
+    void sweepSpool()
+    {
+        auto now = std::chrono::steady_clock::now();
+        std::error_code ec;
+        {
+            std::lock_guard<std::mutex> lock(finishedMutex);
+            while (!finished.empty() && now - finished.front().at > kSpoolMaxAge)
+            {
+                fs::remove(finished.front().path, ec);
+                unreserve(finished.front().bytes);
+                finished.pop_front();
+            }
+        }
+
+        const std::string ours = "body-" + std::to_string(getpid()) + "-";
+        auto fileNow = fs::file_time_type::clock::now();
+        for (fs::directory_iterator it(spoolDir(), ec), end; !ec && it != end; it.increment(ec))
+        {
+            if (it->path().filename().string().compare(0, ours.size(), ours) == 0)
+                continue;
+            std::error_code statEc;
+            auto written = fs::last_write_time(it->path(), statEc);
+            if (!statEc && fileNow - written > kSpoolMaxAge)
+                fs::remove(it->path(), statEc);
+        }
+    }
+}
+
+Spool::Spool(size_t bufferSize) : buffer_(bufferSize) {}
+
+Spool::~Spool()
+{
+    if (file_)
+    {
+        std::fclose(file_);
+        std::error_code ec;
+        fs::remove(path_, ec);
+        unreserve(reserved_);
+    }
+}
+
+bool Spool::open(ContentCoding coding)
+{
+    static std::atomic<unsigned long> counter{0};
+
+    sweepSpool();
+    if (spoolUsed.load(std::memory_order_relaxed) >= spoolLimit.load(std::memory_order_relaxed))
+    {
+        full_ = true;
+        return false;
+    }
+    path_ = (spoolDir() / ("body-" + std::to_string(getpid()) + "-" + std::to_string(counter++))).string();
+    file_ = std::fopen(path_.c_str(), "wb");
+    if (!file_)
+    {
+        std::cerr << "Can't create spool file " << path_ << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    // Writes already go out in buffer-sized chunks; skip stdio's own copy.
+    std::setvbuf(file_, nullptr, _IONBF, 0);
+
+    if (coding != ContentCoding::Identity)
+    {
+        compressor_.reset(new StreamCompressor(coding));
+        if (*compressor_)
+            coding_ = coding;
+        else
+            compressor_.reset();
+    }
+    return true;
+}
+
+void Spool::write(const char *data, size_t len)
+{
+    if (len > buffer_.size() - used_)
+    {
+        flush();
+        if (len >= buffer_.size())
+        {
+            emit(data, len, false);
+            return;
+        }
+    }
+    std::memcpy(buffer_.data() + used_, data, len);
+    used_ += len;
+}
+
+void Spool::flush(bool last)
+{
+    if (used_ || (last && compressor_))
+        emit(buffer_.data(), used_, last);
+    used_ = 0;
+}
+
+void Spool::emit(const char *data, size_t len, bool last)
+{
+    flushed_ = flushed_ || !last;
+    if (!file_)
+        return;
+    if (compressor_)
+    {
+        packed_.clear();
+        if (!compressor_->write(data, len, last, packed_))
+        {
+            failed_ = true;
+            return;
+        }
+        data = packed_.data();
+        len = packed_.size();
+    }
+    if (!reserve(len))
+    {
+        failed_ = full_ = true;
+        return;
+    }
+    reserved_ += len;
+    if (std::fwrite(data, 1, len, file_) != len)
+        failed_ = true;
+}
+
+bool Spool::finish()
+{
+    // A body that never left the buffer is known in full: skip compressing
+    // it if it is too small to gain anything.
+    if (compressor_ && !flushed_ && used_ < kCompressMinBytes)
+    {
+        compressor_.reset();
+        coding_ = ContentCoding::Identity;
+    }
+    flush(true);
+    bool ok = file_ && !failed_;
+    if (file_ && std::fclose(file_) != 0)
+        ok = false;
+    file_ = nullptr;
+    if (!ok)
+    {
+        std::error_code ec;
+        fs::remove(path_, ec);
+        unreserve(reserved_);
+    }
+    else
+    {
+        std::lock_guard<std::mutex> lock(finishedMutex);
+        finished.push_back(Finished{path_, reserved_, std::chrono::steady_clock::now()});
+    }
+    reserved_ = 0;
+    return ok;
+}
+
+void setSpoolLimit(uint64_t bytes)
+{
+    spoolLimit.store(bytes, std::memory_order_relaxed);
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "compress.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Response body that is written to a temporary file through a fixed-size
+// buffer instead of being built up in memory. Once finished, the file is
+// handed to crow::response::set_static_file_info_unsafe, and Crow sends it
+// back to the client in chunks, so peak memory no longer depends on how many
+// rows the body holds. This is spool-then-send, not streaming: the whole
+// body is on disk before its first byte goes out.
+//
+// Crow opens the file as soon as the handler returns, so every open() first
+// unlinks files older than a few seconds (their readers keep them alive
+// until done). Together the spool files may hold at most the limit set with
+// setSpoolLimit: every chunk reserves its bytes against one shared counter
+// before it is written, and a body whose reservation fails fails with
+// full() set, for a 503.
+//
+// With a content coding, each buffer-full is compressed on its way to the
+// file, so the body is encoded as it is produced. A body that finishes
+// under kCompressMinBytes is written as it is; coding() tells which.
+class Spool
+{
+public:
+    explicit Spool(size_t bufferSize = 64 * 1024);
+    ~Spool();
+
+    Spool(const Spool &) = delete;
+    Spool &operator=(const Spool &) = delete;
+
+    // Creates a fresh spool file; returns false if the spool directory is
+    // unusable or already full.
+    bool open(ContentCoding coding = ContentCoding::Identity);
+
+    void write(const char *data, size_t len);
+    void write(const std::string &data) { write(data.data(), data.size()); }
+    void put(char c)
+    {
+        if (used_ == buffer_.size())
+            flush();
+        buffer_[used_++] = c;
+    }
+
+    // Flushes and closes the file; returns false if any write failed or the
+    // body went over the spool limit.
+    bool finish();
+
+    // True if open() or finish() failed because the spool limit was reached.
+    bool full() const { return full_; }
+
+    const std::string &path() const { return path_; }
+
+    // Content-Encoding of the finished file.
+    ContentCoding coding() const { return coding_; }
+
+private:
+    void flush(bool last = false);
+    void emit(const char *data, size_t len, bool last);
+
+    std::vector<char> buffer_;
+    size_t used_ = 0;
+    std::FILE *file_ = nullptr;
+    std::string path_;
+    bool failed_ = false;
+    bool full_ = false;
+    uint64_t reserved_ = 0;  // bytes this file holds against the limit
+    ContentCoding coding_ = ContentCoding::Identity;
+    std::unique_ptr<StreamCompressor> compressor_;
+    std::string packed_;
+    bool flushed_ = false;
+};
+
+// Most bytes all spool files together may hold (1 GiB unless set).
+void setSpoolLimit(uint64_t bytes);
@@ -0,0 +1,73 @@
+#include "startup.h"
+
+#include <cctype>
+#include <cstring>
+#include <iostream>
+
+bool applyJournalMode(DbConnection &db, const std::string &mode)
+{
+    std::string sql = "PRAGMA journal_mode=" + mode + ";";
+    sqlite3_stmt *stmt = nullptr;
+    if (sqlite3_prepare_v2(db.handle(), sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK)
+    {
+        std::cerr << "SQL prepare error: " << sqlite3_errmsg(db.handle()) << std::endl;
+        return false;
+    }
+    std::string applied;
+    if (sqlite3_step(stmt) == SQLITE_ROW)
+        applied = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0));
+    sqlite3_finalize(stmt);
+
+    for (char &c : applied)
+        c = std::toupper(static_cast<unsigned char>(c));
+    if (applied != mode)
+    {
+        std::cerr << "journal_mode " << mode << " not applied, database uses "
+                  << (applied.empty() ? "unknown" : applied) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool checkIntegrity(DbConnection &db, const std::string &mode)
+{
+    if (mode == "off")
+        return true;
+
+    Stmt stmt(db, mode == "full" ? "PRAGMA integrity_check;" : "PRAGMA quick_check;");
+    if (!stmt)
+        return false;
+    bool ok = true;
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
+    {
+        const char *message = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0));
+        if (message && std::strcmp(message, "ok") == 0)
+            continue;
+        std::cerr << "Integrity check: " << (message ? message : "(null)") << std::endl;
+        ok = false;
+    }
+    if (rc != SQLITE_DONE)
+    {
+        std::cerr << "Integrity check failed: " << sqlite3_errmsg(db.handle()) << std::endl;
+        return false;
+    }
+    return ok;
+}
+
+void warmUp(DbConnection &db)
+{
+    // Each statement walks one b-tree end to end.
+    static const char *const kWarmUp[] = {
+        "SELECT count(*) FROM accounts",
+        "SELECT count(*) FROM users WHERE date_iso >= ''",
+        "SELECT count(*) FROM users_fts_idx",
+        "SELECT sum(length(block)) FROM users_fts_data",
+    };
+    for (const char *sql : kWarmUp)
+    {
+        Stmt stmt(db, sql);
+        while (stmt && sqlite3_step(stmt) == SQLITE_ROW)
+            ;
+    }
+}
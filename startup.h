@@ -0,0 +1,19 @@
+#pragma once
+
+#include "db.h"
+
+#include <string>
+
+// Sets the database-wide journal mode. Logs and returns false if SQLite
+// keeps a different one (WAL is refused on some network file systems).
+bool applyJournalMode(DbConnection &db, const std::string &mode);
+
+// Runs PRAGMA quick_check ("quick") or integrity_check ("full"); "off" skips
+// it. Logs every problem reported and returns false if there were any.
+bool checkIntegrity(DbConnection &db, const std::string &mode);
+
+// Reads the b-trees every request path touches (indexes, the search index,
+// accounts) so their pages are in the OS page cache, and with mmap_size set
+// already mapped, before the first request arrives. The users table itself
+// is read in full by PatientCache::load.
+void warmUp(DbConnection &db);
@@ -0,0 +1,155 @@
+#include "static_page.h"
+
+#include <brotli/encode.h>
+#include <zlib.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <strings.h>
+
+namespace
+{
+    std::string strongEtag(const std::string &body, const char *suffix)
+    {
+        // FNV-1a is plenty to tell builds of the same page apart.
+        uint64_t hash = 1469598103934665603ull;
+        for (unsigned char c : body)
+        {
+            hash ^= c;
+            hash *= 1099511628211ull;
+        }
+        char buf[40];
+        std::snprintf(buf, sizeof(buf), "\"%016llx%s\"", (unsigned long long)hash, suffix);
+        return buf;
+    }
+
+    bool isTokenChar(char c)
+    {
+        return c != ',' && c != ';' && c != ' ' && c != '\t';
+    }
+}
+
+std::string gzipCompress(const std::string &data, int level)
+{
+    z_stream zs;
+    std::memset(&zs, 0, sizeof(zs));
+    // 15 window bits plus 16 selects the gzip wrapper instead of zlib's.
+    if (deflateInit2(&zs, level, Z_DEFLATED, 15 + 16, 9, Z_DEFAULT_STRATEGY) != Z_OK)
+        return {};
+
+    std::string out(deflateBound(&zs, data.size()), '\0');
+    zs.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.data()));
+    zs.avail_in = data.size();
+    zs.next_out = reinterpret_cast<Bytef *>(&out[0]);
+    zs.avail_out = out.size();
+    int rc = deflate(&zs, Z_FINISH);
+    out.resize(zs.total_out);
+    deflateEnd(&zs);
+    return rc == Z_STREAM_END ? out : std::string();
+}
+
+std::string brotliCompress(const std::string &data, int quality)
+{
+    size_t size = BrotliEncoderMaxCompressedSize(data.size());
+    if (size == 0)
+        return {};
+    std::string out(size, '\0');
+    if (!BrotliEncoderCompress(quality, BROTLI_DEFAULT_WINDOW, BROTLI_MODE_TEXT, data.size(),
+                               reinterpret_cast<const uint8_t *>(data.data()), &size,
+                               reinterpret_cast<uint8_t *>(&out[0])))
+        return {};
+    out.resize(size);
+    return out;
+}
+
+bool acceptsEncoding(const std::string &acceptEncoding, const char *coding)
+{
+    size_t len = std::strlen(coding);
+    size_t pos = 0;
+    while (pos < acceptEncoding.size())
+    {
+        size_t end = acceptEncoding.find(',', pos);
+        if (end == std::string::npos)
+            end = acceptEncoding.size();
+
+        size_t start = pos;
+        while (start < end && (acceptEncoding[start] == ' ' || acceptEncoding[start] == '\t'))
+            ++start;
+        size_t tokenEnd = start;
+        while (tokenEnd < end && isTokenChar(acceptEncoding[tokenEnd]))
+            ++tokenEnd;
+
+        if (tokenEnd - start == len && strncasecmp(acceptEncoding.data() + start, coding, len) == 0)
+        {
+            size_t q = acceptEncoding.find("q=", tokenEnd);
+            if (q == std::string::npos || q >= end)
+                return true;
+            return std::strtod(acceptEncoding.c_str() + q + 2, nullptr) > 0;
+        }
+        pos = end + 1;
+    }
+    return false;
+}
+
+StaticPage::StaticPage(std::string body, std::string contentType, std::string cacheControl)
+    : contentType_(std::move(contentType)), cacheControl_(std::move(cacheControl))
+{
+    identity_.etag = strongEtag(body, "");
+    identity_.encoding = nullptr;
+    gzip_.body = gzipCompress(body);
+    gzip_.etag = strongEtag(body, "-gz");
+    gzip_.encoding = "gzip";
+    brotli_.body = brotliCompress(body);
+    brotli_.etag = strongEtag(body, "-br");
+    brotli_.encoding = "br";
+    identity_.body = std::move(body);
+}
+
+const StaticPage::Variant &StaticPage::select(const crow::request &req) const
+{
+    const std::string &accept = req.get_header_value("Accept-Encoding");
+    if (accept.empty())
+        return identity_;
+    if (!brotli_.body.empty() && brotli_.body.size() < identity_.body.size() && acceptsEncoding(accept, "br"))
+        return brotli_;
+    if (!gzip_.body.empty() && gzip_.body.size() < identity_.body.size() && acceptsEncoding(accept, "gzip"))
+        return gzip_;
+    return identity_;
+}
+
+bool StaticPage::matches(const std::string &ifNoneMatch) const
+{
+    if (ifNoneMatch.empty())
+        return false;
+    if (ifNoneMatch.find('*') != std::string::npos)
+        return true;
+    // Any encoding's tag names the same content, so a cached copy of one is
+    // still current when the client now negotiates another.
+    for (const Variant *v : {&identity_, &gzip_, &brotli_})
+        if (ifNoneMatch.find(v->etag) != std::string::npos)
+            return true;
+    return false;
+}
+
+crow::response StaticPage::serve(const crow::request &req) const
+{
+    const Variant &variant = select(req);
+    crow::response res;
+    if (matches(req.get_header_value("If-None-Match")))
+    {
+        res.code = 304;
+    }
+    else
+    {
+        res.body = variant.body;
+        res.set_header("Content-Type", contentType_);
+        if (variant.encoding)
+            res.set_header("Content-Encoding", variant.encoding);
+    }
+    res.set_header("ETag", variant.etag);
+    res.set_header("Cache-Control", cacheControl_);
+    res.set_header("Vary", "Accept-Encoding");
+    return res;
+}
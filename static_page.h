@@ -0,0 +1,47 @@
+#pragma once
+
+#include "crow.h"
+
+#include <string>
+
+// A constant response body prepared once at startup: the identity body plus
+// gzip and brotli encodings, each with its own strong ETag, and the
+// Cache-Control policy to send with it. Serving it is a header comparison
+// and a copy of an already built string.
+class StaticPage
+{
+public:
+    StaticPage(std::string body, std::string contentType, std::string cacheControl);
+
+    // Answers If-None-Match with 304, otherwise picks the smallest encoding
+    // the client accepts.
+    crow::response serve(const crow::request &req) const;
+
+    const std::string &etag() const { return identity_.etag; }
+
+private:
+    struct Variant
+    {
+        std::string body;
+        std::string etag;
+        const char *encoding;
+    };
+
+    const Variant &select(const crow::request &req) const;
+    bool matches(const std::string &ifNoneMatch) const;
+
+    Variant identity_;
+    Variant gzip_;
+    Variant brotli_;
+    std::string contentType_;
+    std::string cacheControl_;
+};
+
+// Compresses `data` as a gzip member; returns an empty string on failure.
+std::string gzipCompress(const std::string &data, int level = 9);
+
+// Compresses `data` with brotli; returns an empty string on failure.
+std::string brotliCompress(const std::string &data, int quality = 11);
+
+// True if the Accept-Encoding header value allows `coding` (q > 0).
+bool acceptsEncoding(const std::string &acceptEncoding, const char *coding);
@@ -0,0 +1,183 @@
+// The default read lane must be reachable: with every Crow worker busy on a
+// read, one at most per worker, some of those reads are shed with a 503
+// while writes still get in. Requests queued for a full lane are let in
+// writes first, and shed when the queue is full or their wait runs out.
+#include "admission.h"
+#include "config.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    int failures = 0;
+
+    void check(bool ok, const char *what, unsigned workers)
+    {
+        if (!ok)
+        {
+            std::fprintf(stderr, "FAILED with %u workers: %s\n", workers, what);
+            ++failures;
+        }
+    }
+
+    void saturate(unsigned workers)
+    {
+        setenv("HMS_THREADS", std::to_string(workers).c_str(), 1);
+        Config config;
+        check(loadConfig(config), "loadConfig", workers);
+        check(config.maxReads >= 1 && (unsigned)config.maxReads <= workers, "read limit within the workers", workers);
+
+        AdmissionLimits limits;
+        limits.maxReads = config.maxReads;
+        limits.maxWrites = config.maxWrites;
+        limits.maxInFlight = static_cast<int>(workers);
+        limits.maxQueued = config.admissionQueue;
+        limits.maxWait = std::chrono::milliseconds(config.admissionWaitMs);
+        AdmissionControl admission(limits);
+
+        // Each worker thread takes one read and holds it until all have tried.
+        std::atomic<unsigned> tried{0}, admitted{0}, overloaded{0};
+        std::atomic<bool> done{false};
+        std::vector<std::thread> threads;
+        for (unsigned i = 0; i < workers; ++i)
+        {
+            threads.emplace_back([&, i] {
+                int retryAfter = 0;
+                Admission result = admission.admit("10.0.0." + std::to_string(i), RequestClass::Read, true, retryAfter);
+                if (result == Admission::Admitted)
+                    admitted.fetch_add(1);
+                else if (result == Admission::Overloaded && retryAfter > 0)
+                    overloaded.fetch_add(1);
+                tried.fetch_add(1);
+                while (!done.load())
+                    std::this_thread::yield();
+                if (result == Admission::Admitted)
+                    admission.release(RequestClass::Read);
+            });
+        }
+        while (tried.load() < workers)
+            std::this_thread::yield();
+
+        check(admitted.load() == (unsigned)config.maxReads, "reads admitted up to the limit", workers);
+        check(overloaded.load() == workers - config.maxReads, "the rest shed", workers);
+        if (workers > 1)
+            check(overloaded.load() > 0, "a read shed with every worker busy", workers);
+
+        int retryAfter = 0;
+        check(admission.admit("10.0.1.1", RequestClass::Read, true, retryAfter) == Admission::Overloaded,
+              "a further read shed", workers);
+        // A lone worker busy on a read has nothing left to serve a write with.
+        if (workers > 1)
+        {
+            Admission write = admission.admit("10.0.1.2", RequestClass::Write, true, retryAfter);
+            check(write == Admission::Admitted, "a write admitted while reads are saturated", workers);
+            if (write == Admission::Admitted)
+                admission.release(RequestClass::Write);
+        }
+
+        done.store(true);
+        for (std::thread &thread : threads)
+            thread.join();
+        check(admission.admit("10.0.1.3", RequestClass::Read, true, retryAfter) == Admission::Admitted,
+              "a read admitted once the lane drained", workers);
+        admission.release(RequestClass::Read);
+
+        std::string metrics = admission.renderMetrics();
+        std::string shed = "hms_admission_shed_total{class=\"read\",reason=\"overloaded\"} ";
+        check(metrics.find(shed + std::to_string(overloaded.load() + 1) + "\n") != std::string::npos,
+              "shed reads counted", workers);
+    }
+
+    // Admits one request of `cls` on its own thread, which then holds the
+    // slot until `done`; `result` is set once admit() returns.
+    std::thread holder(AdmissionControl &admission, RequestClass cls, std::atomic<int> &result,
+                       std::atomic<bool> &done)
+    {
+        return std::thread([&admission, cls, &result, &done] {
+            int retryAfter = 0;
+            Admission admitted = admission.admit("10.0.2.1", cls, true, retryAfter);
+            result.store(static_cast<int>(admitted));
+            while (!done.load())
+                std::this_thread::yield();
+            if (admitted == Admission::Admitted)
+                admission.release(cls);
+        });
+    }
+
+    bool waitFor(const std::atomic<int> &result, int expected)
+    {
+        for (int i = 0; i < 2000 && result.load() != expected; ++i)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        return result.load() == expected;
+    }
+
+    // A full lane queues up to maxQueued requests per class, hands a freed
+    // slot to a queued write before a read queued earlier, and sheds what
+    // does not fit or waits too long.
+    void queueing()
+    {
+        const int kPending = -1, kAdmitted = static_cast<int>(Admission::Admitted);
+        AdmissionLimits limits;
+        limits.maxReads = 2;
+        limits.maxWrites = 2;
+        limits.maxInFlight = 1;
+        limits.maxQueued = 1;
+        limits.maxWait = std::chrono::seconds(5);
+        AdmissionControl admission(limits);
+
+        int retryAfter = 0;
+        check(admission.admit("10.0.3.1", RequestClass::Read, true, retryAfter) == Admission::Admitted,
+              "first read admitted", 0);
+
+        std::atomic<int> read{kPending}, write{kPending};
+        std::atomic<bool> readDone{false}, writeDone{false};
+        std::thread reader = holder(admission, RequestClass::Read, read, readDone);
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        std::thread writer = holder(admission, RequestClass::Write, write, writeDone);
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        check(read.load() == kPending && write.load() == kPending, "both queued while the slot is held", 0);
+        check(admission.admit("10.0.3.2", RequestClass::Read, true, retryAfter) == Admission::Overloaded,
+              "a read shed at once when its queue is full", 0);
+
+        admission.release(RequestClass::Read);
+        check(waitFor(write, kAdmitted), "the queued write let in first", 0);
+        check(read.load() == kPending, "the earlier read still queued", 0);
+        writeDone.store(true);
+        writer.join();
+        check(waitFor(read, kAdmitted), "the read let in after the write", 0);
+
+        // Nothing frees the slot now, so the next read waits out its bound.
+        AdmissionLimits shortLimits = limits;
+        shortLimits.maxWait = std::chrono::milliseconds(30);
+        AdmissionControl shortWait(shortLimits);
+        check(shortWait.admit("10.0.3.3", RequestClass::Read, true, retryAfter) == Admission::Admitted,
+              "read admitted", 0);
+        auto started = std::chrono::steady_clock::now();
+        check(shortWait.admit("10.0.3.4", RequestClass::Read, true, retryAfter) == Admission::Overloaded,
+              "a queued read shed when its wait runs out", 0);
+        check(std::chrono::steady_clock::now() - started >= std::chrono::milliseconds(30), "shed after the bound", 0);
+        check(shortWait.renderMetrics().find("hms_admission_queued_total{class=\"read\"} 1\n") != std::string::npos,
+              "queued reads counted", 0);
+        shortWait.release(RequestClass::Read);
+
+        readDone.store(true);
+        reader.join();
+    }
+}
+
+int main()
+{
+    for (unsigned workers : {1u, 2u, 3u, 4u, 8u, 16u, 64u})
+        saturate(workers);
+    queueing();
+    if (failures)
+        return 1;
+    std::printf("admission: ok\n");
+    return 0;
+}
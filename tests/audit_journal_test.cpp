@@ -0,0 +1,124 @@
+// A /users/bulk chunk's worth of audit records, queued at once from one
+// thread as the commit hook does, must fit in the ring without record()
+// waiting, even if the writer never drains on its own; with concurrent
+// recorders on top, every record must reach the segments and none may be
+// dropped.
+#include "audit_journal.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <dirent.h>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace
+{
+    int failures = 0;
+
+    void check(bool ok, const char *what)
+    {
+        if (!ok)
+        {
+            std::fprintf(stderr, "FAILED: %s\n", what);
+            ++failures;
+        }
+    }
+
+    unsigned long long counter(const std::string &metrics, const std::string &name)
+    {
+        size_t at = metrics.find("\n" + name + " ");
+        return at == std::string::npos ? ~0ull : std::strtoull(metrics.c_str() + at + name.size() + 2, nullptr, 10);
+    }
+
+    size_t countLines(const std::string &dir)
+    {
+        size_t lines = 0;
+        DIR *handle = opendir(dir.c_str());
+        while (dirent *entry = handle ? readdir(handle) : nullptr)
+        {
+            if (entry->d_name[0] == '.')
+                continue;
+            std::ifstream in(dir + "/" + entry->d_name);
+            std::string line;
+            while (std::getline(in, line))
+                ++lines;
+        }
+        if (handle)
+            closedir(handle);
+        return lines;
+    }
+
+    void removeDir(const std::string &dir)
+    {
+        DIR *handle = opendir(dir.c_str());
+        while (dirent *entry = handle ? readdir(handle) : nullptr)
+            if (entry->d_name[0] != '.')
+                unlink((dir + "/" + entry->d_name).c_str());
+        if (handle)
+            closedir(handle);
+        rmdir(dir.c_str());
+    }
+}
+
+int main()
+{
+    char path[] = "/tmp/hms-audit-test-XXXXXX";
+    if (!mkdtemp(path))
+        return 1;
+    std::string dir = path;
+
+    const int kBulkRows = 10000;  // kBulkChunkRows
+    const int kThreads = 4, kPerThread = 5000;
+    std::string metrics;
+    {
+        // A flush interval the test never reaches: only the half-ring wakes
+        // and stop() drain the ring.
+        AuditJournal journal(dir, 1 << 20, std::chrono::seconds(60));
+        check(journal.start(), "start");
+
+        Patient patient;
+        patient.name = "Bulk Patient";
+        patient.phone = "+92-300-1234567";
+        patient.disease = "Influenza";
+        patient.date = "2025-03-07 09:30";
+        for (int i = 0; i < kBulkRows; ++i)
+        {
+            patient.id = i + 1;
+            check(journal.record("importer", AuditJournal::Op::Add, patient), "bulk record queued");
+        }
+        check(counter(journal.renderMetrics(), "hms_audit_waits_total") == 0, "a bulk chunk queued without waiting");
+
+        std::vector<std::thread> threads;
+        for (int t = 0; t < kThreads; ++t)
+            threads.emplace_back([&journal, t] {
+                Patient edited;
+                edited.name = "Edited";
+                for (int i = 0; i < kPerThread; ++i)
+                {
+                    edited.id = t * kPerThread + i + 1;
+                    journal.record("clerk", AuditJournal::Op::Edit, edited);
+                }
+            });
+        for (std::thread &thread : threads)
+            thread.join();
+
+        journal.stop();
+        metrics = journal.renderMetrics();
+    }
+
+    unsigned long long total = kBulkRows + kThreads * kPerThread;
+    check(counter(metrics, "hms_audit_dropped_total") == 0, "no record dropped");
+    check(counter(metrics, "hms_audit_records_total") == total, "every record queued");
+    check(counter(metrics, "hms_audit_written_total") == total, "every record written");
+    check(countLines(dir) == total, "every record is a line in a segment");
+    removeDir(dir);
+
+    if (failures)
+        std::fputs(metrics.c_str(), stderr);
+    else
+        std::printf("audit journal: %llu records, none dropped\n", total);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,55 @@
+// Request ids and durations are read with JsonView::Value::integer(): only
+// a number written as an integer that fits in int64 may pass, so a handler
+// never edits patient 1 for {"id": 1.9} or patient 0 for an overflow.
+#include "arena.h"
+#include "json_view.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+namespace
+{
+    int failures = 0;
+
+    void expect(const std::string &body, bool ok, int64_t expected = 0)
+    {
+        ArenaScope scope;
+        JsonView json(scope.arena());
+        int64_t value = -12345;
+        bool parsed = json.parse(body);
+        bool got = parsed && json.root()["id"].integer(value);
+        if (got != ok || (ok && value != expected))
+        {
+            std::fprintf(stderr, "FAILED: %s gave %s %lld\n", body.c_str(), got ? "true" : "false",
+                         (long long)value);
+            ++failures;
+        }
+    }
+}
+
+int main()
+{
+    expect("{\"id\":42}", true, 42);
+    expect("{\"id\":-7}", true, -7);
+    expect("{\"id\":0}", true, 0);
+    expect("{\"id\":9223372036854775807}", true, INT64_MAX);
+    expect("{\"id\":-9223372036854775808}", true, INT64_MIN);
+
+    expect("{\"id\":1.9}", false);
+    expect("{\"id\":1.0}", false);
+    expect("{\"id\":1e3}", false);
+    expect("{\"id\":2E-1}", false);
+    expect("{\"id\":9223372036854775808}", false);
+    expect("{\"id\":-9223372036854775809}", false);
+    expect("{\"id\":99999999999999999999999}", false);
+    expect("{\"id\":\"42\"}", false);
+    expect("{\"id\":null}", false);
+    expect("{\"id\":true}", false);
+    expect("{}", false);
+
+    if (failures)
+        return 1;
+    std::printf("json view: ok\n");
+    return 0;
+}
@@ -0,0 +1,160 @@
+#include "user_format.h"
+
+#include "user_rows.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <strings.h>
+
+namespace
+{
+    struct FormatInfo
+    {
+        UserFormat format;
+        const char *name;
+        const char *mediaTypes[3];  // first one is sent as Content-Type
+    };
+
+    const FormatInfo kFormats[] = {
+        {UserFormat::Json, "json", {"application/json"}},
+        {UserFormat::Ndjson, "ndjson", {"application/x-ndjson", "application/ndjson"}},
+        {UserFormat::Csv, "csv", {"text/csv"}},
+        {UserFormat::Cbor, "cbor", {"application/cbor"}},
+        {UserFormat::MsgPack, "msgpack", {"application/msgpack", "application/x-msgpack", "application/vnd.msgpack"}},
+    };
+
+    const FormatInfo &info(UserFormat format)
+    {
+        return kFormats[(int)format];
+    }
+
+    // How closely `range` (type/subtype, type/* or */*) matches `type`:
+    // 3 for an exact match, 2 for type/*, 1 for */*, 0 for none.
+    int specificity(const std::string &range, const char *type)
+    {
+        if (range == "*/*")
+            return 1;
+        size_t slash = range.find('/');
+        if (slash != std::string::npos && range.compare(slash, std::string::npos, "/*") == 0 &&
+            strncasecmp(range.c_str(), type, slash + 1) == 0)
+            return 2;
+        return strcasecmp(range.c_str(), type) == 0 ? 3 : 0;
+    }
+
+    std::string trim(const std::string &text, size_t begin, size_t end)
+    {
+        while (begin < end && (text[begin] == ' ' || text[begin] == '\t'))
+            ++begin;
+        while (end > begin && (text[end - 1] == ' ' || text[end - 1] == '\t'))
+            --end;
+        return text.substr(begin, end - begin);
+    }
+
+    // q-value the Accept header gives `format`: that of its most specific
+    // matching media range, or -1 if none matches.
+    double quality(const std::string &accept, UserFormat format)
+    {
+        int best = 0;
+        double q = -1;
+        for (size_t pos = 0; pos <= accept.size();)
+        {
+            size_t end = accept.find(',', pos);
+            if (end == std::string::npos)
+                end = accept.size();
+            size_t semi = accept.find(';', pos);
+            std::string range = trim(accept, pos, semi < end ? semi : end);
+
+            double rangeQ = 1;
+            for (size_t param = semi; param < end; param = accept.find(';', param + 1))
+            {
+                std::string p = trim(accept, param + 1, std::min(accept.find(';', param + 1), end));
+                if (p.size() > 2 && (p[0] == 'q' || p[0] == 'Q') && p[1] == '=')
+                    rangeQ = std::strtod(p.c_str() + 2, nullptr);
+            }
+
+            for (const char *type : info(format).mediaTypes)
+            {
+                int s = type ? specificity(range, type) : 0;
+                if (s > best)
+                {
+                    best = s;
+                    q = rangeQ;
+                }
+            }
+            pos = end + 1;
+        }
+        return q;
+    }
+
+    void appendJsonLine(std::string &out, sqlite3_stmt *stmt)
+    {
+        appendUserJson(out, stmt);
+        out.push_back('\n');
+    }
+}
+
+bool parseUserFormat(const std::string &name, UserFormat &format)
+{
+    for (const FormatInfo &f : kFormats)
+    {
+        if (name == f.name)
+        {
+            format = f.format;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool negotiateUserFormat(const std::string &accept, std::initializer_list<UserFormat> offered, UserFormat &format)
+{
+    if (accept.empty())
+    {
+        format = *offered.begin();
+        return true;
+    }
+    double bestQ = 0;
+    for (UserFormat candidate : offered)
+    {
+        double q = quality(accept, candidate);
+        if (q > bestQ)
+        {
+            bestQ = q;
+            format = candidate;
+        }
+    }
+    return bestQ > 0;
+}
+
+UserListLayout userListLayout(UserFormat format, uint64_t count)
+{
+    UserListLayout layout{info(format).mediaTypes[0], "", "", "", nullptr};
+    switch (format)
+    {
+    case UserFormat::Json:
+        layout.open = "[";
+        layout.separator = ",";
+        layout.close = "]";
+        layout.appendRow = [](std::string &out, sqlite3_stmt *stmt) { appendUserJson(out, stmt); };
+        break;
+    case UserFormat::Ndjson:
+        layout.appendRow = appendJsonLine;
+        break;
+    case UserFormat::Csv:
+        layout.contentType = "text/csv; charset=utf-8";
+        layout.open = kUserCsvHeader;
+        layout.appendRow = appendUserCsv;
+        break;
+    case UserFormat::Cbor:
+        // Indefinite length, so the count is never needed up front.
+        layout.open = "\x9f";
+        layout.close = "\xff";
+        layout.appendRow = appendUserCbor;
+        break;
+    case UserFormat::MsgPack:
+        appendMsgPackArray(layout.open, count);
+        layout.appendRow = appendUserMsgPack;
+        break;
+    }
+    return layout;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <sqlite3.h>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+
+// Encodings of a list of users rows. JSON is the default; the binary ones
+// carry the same maps as the JSON objects, with the same keys.
+enum class UserFormat
+{
+    Json,     // application/json array
+    Ndjson,   // application/x-ndjson, one object per line
+    Csv,      // text/csv with a header line
+    Cbor,     // application/cbor indefinite-length array
+    MsgPack,  // application/msgpack array
+};
+
+// Parses a ?format= value: json, ndjson, csv, cbor or msgpack.
+bool parseUserFormat(const std::string &name, UserFormat &format);
+
+// Picks the format for an Accept header value from `offered`, which is in
+// the server's order of preference; that order breaks ties in q-value. A
+// missing header gets the first one. Returns false if the client accepts
+// none of them (406).
+bool negotiateUserFormat(const std::string &accept, std::initializer_list<UserFormat> offered, UserFormat &format);
+
+// How a list of rows from `SELECT id, name, phone, disease, date` is laid
+// out in one format: what goes before, between and after the rows, and how
+// each row is written.
+struct UserListLayout
+{
+    const char *contentType;
+    std::string open;
+    std::string separator;
+    std::string close;
+    void (*appendRow)(std::string &out, sqlite3_stmt *stmt);
+};
+
+// True if the layout's header holds the row count, which then has to be
+// known before the first row is written (MessagePack arrays).
+inline bool layoutNeedsCount(UserFormat format)
+{
+    return format == UserFormat::MsgPack;
+}
+
+UserListLayout userListLayout(UserFormat format, uint64_t count = 0);
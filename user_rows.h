@@ -0,0 +1,218 @@
+#pragma once
+
+#include "json_writer.h"
+
+#include <sqlite3.h>
+#include <string>
+
+// Serializers for the current row of a
+// `SELECT id, name, phone, disease, date FROM users ...` statement.
+
+inline void appendColumnJson(JsonWriter &json, sqlite3_stmt *stmt, int col)
+{
+    // column_text before column_bytes, so the length is that of the UTF-8 text.
+    const char *text = reinterpret_cast<const char *>(sqlite3_column_text(stmt, col));
+    json.string(text, sqlite3_column_bytes(stmt, col));
+}
+
+inline void appendUserJson(std::string &out, sqlite3_stmt *stmt)
+{
+    JsonWriter json(out);
+    json.raw('{');
+    json.key("id");
+    json.integer(sqlite3_column_int64(stmt, 0));
+    json.raw(',');
+    json.key("name");
+    appendColumnJson(json, stmt, 1);
+    json.raw(',');
+    json.key("phone");
+    appendColumnJson(json, stmt, 2);
+    json.raw(',');
+    json.key("disease");
+    appendColumnJson(json, stmt, 3);
+    json.raw(',');
+    json.key("date");
+    appendColumnJson(json, stmt, 4);
+    json.raw('}');
+}
+
+// Same object as appendUserJson, from values rather than a statement row.
+inline void appendUserJson(std::string &out, sqlite3_int64 id, std::string_view name, std::string_view phone,
+                           std::string_view disease, std::string_view date)
+{
+    JsonWriter json(out);
+    json.raw('{');
+    json.key("id");
+    json.integer(id);
+    json.raw(',');
+    json.key("name");
+    json.string(name);
+    json.raw(',');
+    json.key("phone");
+    json.string(phone);
+    json.raw(',');
+    json.key("disease");
+    json.string(disease);
+    json.raw(',');
+    json.key("date");
+    json.string(date);
+    json.raw('}');
+}
+
+// Appends one CSV field, quoted only if it contains a delimiter, quote or newline.
+inline void appendCsvField(std::string &out, const char *text, size_t len)
+{
+    if (!text)
+        return;
+    bool quote = false;
+    for (size_t i = 0; i < len && !quote; ++i)
+        quote = text[i] == ',' || text[i] == '"' || text[i] == '\n' || text[i] == '\r';
+    if (!quote)
+    {
+        out.append(text, len);
+        return;
+    }
+    out.push_back('"');
+    for (size_t i = 0; i < len; ++i)
+    {
+        if (text[i] == '"')
+            out.push_back('"');
+        out.push_back(text[i]);
+    }
+    out.push_back('"');
+}
+
+// One CSV line (with trailing newline) in the column order of kUserCsvHeader.
+inline void appendUserCsv(std::string &out, sqlite3_stmt *stmt)
+{
+    char digits[20];
+    auto end = std::to_chars(digits, digits + sizeof(digits), (int64_t)sqlite3_column_int64(stmt, 0)).ptr;
+    out.append(digits, end - digits);
+    for (int col = 1; col <= 4; ++col)
+    {
+        out.push_back(',');
+        const char *text = reinterpret_cast<const char *>(sqlite3_column_text(stmt, col));
+        appendCsvField(out, text, sqlite3_column_bytes(stmt, col));
+    }
+    out.push_back('\n');
+}
+
+static const char kUserCsvHeader[] = "id,name,phone,disease,date\n";
+
+// CBOR (RFC 8949) head: major type in the top three bits, then the argument
+// in the fewest bytes that hold it, big-endian.
+inline void appendCborHead(std::string &out, unsigned major, uint64_t value)
+{
+    unsigned char head[9];
+    size_t len = 1;
+    unsigned char type = static_cast<unsigned char>(major << 5);
+    if (value < 24)
+        head[0] = type | static_cast<unsigned char>(value);
+    else
+    {
+        int bytes = value <= 0xff ? 1 : value <= 0xffff ? 2 : value <= 0xffffffffull ? 4 : 8;
+        head[0] = type | static_cast<unsigned char>(bytes == 1 ? 24 : bytes == 2 ? 25 : bytes == 4 ? 26 : 27);
+        for (int i = bytes - 1; i >= 0; --i)
+            head[len++] = static_cast<unsigned char>(value >> (8 * i));
+    }
+    out.append(reinterpret_cast<const char *>(head), len);
+}
+
+inline void appendCborText(std::string &out, const char *text, size_t len)
+{
+    if (!text)
+    {
+        out.push_back(static_cast<char>(0xf6));  // null
+        return;
+    }
+    appendCborHead(out, 3, len);
+    out.append(text, len);
+}
+
+// The same object as appendUserJson, as a CBOR map with text keys.
+inline void appendUserCbor(std::string &out, sqlite3_stmt *stmt)
+{
+    static const char *const keys[] = {"name", "phone", "disease", "date"};
+    out.append("\xa5\x62id", 4);
+    int64_t id = sqlite3_column_int64(stmt, 0);
+    if (id >= 0)
+        appendCborHead(out, 0, static_cast<uint64_t>(id));
+    else
+        appendCborHead(out, 1, static_cast<uint64_t>(-1 - id));
+    for (int col = 1; col <= 4; ++col)
+    {
+        appendCborText(out, keys[col - 1], std::strlen(keys[col - 1]));
+        const char *text = reinterpret_cast<const char *>(sqlite3_column_text(stmt, col));
+        appendCborText(out, text, sqlite3_column_bytes(stmt, col));
+    }
+}
+
+// MessagePack big-endian integer of `bytes` bytes after a type byte.
+inline void appendMsgPackFixed(std::string &out, unsigned char type, uint64_t value, int bytes)
+{
+    unsigned char buf[9] = {type};
+    for (int i = 0; i < bytes; ++i)
+        buf[1 + i] = static_cast<unsigned char>(value >> (8 * (bytes - 1 - i)));
+    out.append(reinterpret_cast<const char *>(buf), 1 + bytes);
+}
+
+inline void appendMsgPackInt(std::string &out, int64_t value)
+{
+    if (value >= 0 && value < 128)
+        out.push_back(static_cast<char>(value));
+    else if (value >= -32 && value < 0)
+        out.push_back(static_cast<char>(value));
+    else if (value >= 0)
+    {
+        int bytes = value <= 0xff ? 1 : value <= 0xffff ? 2 : value <= 0xffffffffll ? 4 : 8;
+        unsigned char type = bytes == 1 ? 0xcc : bytes == 2 ? 0xcd : bytes == 4 ? 0xce : 0xcf;
+        appendMsgPackFixed(out, type, static_cast<uint64_t>(value), bytes);
+    }
+    else
+    {
+        int bytes = value >= -0x80 ? 1 : value >= -0x8000 ? 2 : value >= -0x80000000ll ? 4 : 8;
+        unsigned char type = bytes == 1 ? 0xd0 : bytes == 2 ? 0xd1 : bytes == 4 ? 0xd2 : 0xd3;
+        appendMsgPackFixed(out, type, static_cast<uint64_t>(value), bytes);
+    }
+}
+
+inline void appendMsgPackStr(std::string &out, const char *text, size_t len)
+{
+    if (!text)
+        out.push_back(static_cast<char>(0xc0));  // nil
+    else if (len < 32)
+        out.push_back(static_cast<char>(0xa0 | len));
+    else if (len <= 0xff)
+        appendMsgPackFixed(out, 0xd9, len, 1);
+    else if (len <= 0xffff)
+        appendMsgPackFixed(out, 0xda, len, 2);
+    else
+        appendMsgPackFixed(out, 0xdb, len, 4);
+    if (text)
+        out.append(text, len);
+}
+
+// Header of a MessagePack array of `count` elements.
+inline void appendMsgPackArray(std::string &out, uint64_t count)
+{
+    if (count < 16)
+        out.push_back(static_cast<char>(0x90 | count));
+    else if (count <= 0xffff)
+        appendMsgPackFixed(out, 0xdc, count, 2);
+    else
+        appendMsgPackFixed(out, 0xdd, count, 4);
+}
+
+// The same object as appendUserJson, as a MessagePack map.
+inline void appendUserMsgPack(std::string &out, sqlite3_stmt *stmt)
+{
+    static const char *const keys[] = {"name", "phone", "disease", "date"};
+    out.append("\x85\xa2id", 4);
+    appendMsgPackInt(out, sqlite3_column_int64(stmt, 0));
+    for (int col = 1; col <= 4; ++col)
+    {
+        appendMsgPackStr(out, keys[col - 1], std::strlen(keys[col - 1]));
+        const char *text = reinterpret_cast<const char *>(sqlite3_column_text(stmt, col));
+        appendMsgPackStr(out, text, sqlite3_column_bytes(stmt, col));
+    }
+}
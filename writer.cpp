@@ -0,0 +1,222 @@
+#include "writer.h"
+
+#include "metrics.h"
+
+#include <iostream>
+#include <vector>
+
+WriteResult stepWrite(DbConnection &conn, sqlite3_stmt *stmt)
+{
+    WriteResult result;
+    if (!stmt)
+    {
+        result.rc = SQLITE_ERROR;
+        return result;
+    }
+    result.rc = sqlite3_step(stmt);
+    if (result.rc == SQLITE_DONE)
+    {
+        result.rowid = sqlite3_last_insert_rowid(conn.handle());
+        result.changes = sqlite3_changes(conn.handle());
+    }
+    return result;
+}
+
+bool WriteQueue::start()
+{
+    conn_ = pool_.open();
+    if (!conn_)
+        return false;
+    for (WriteListener *listener : listeners_)
+        listener->writerStarted(*conn_);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    running_ = true;
+    thread_ = std::thread(&WriteQueue::loop, this);
+    return true;
+}
+
+void WriteQueue::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_)
+            return;
+        running_ = false;
+    }
+    wake_.notify_one();
+    thread_.join();
+    conn_.reset();
+}
+
+WriteResult WriteQueue::run(Job job, CommitHook onCommit)
+{
+    std::future<WriteResult> result;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_)
+        {
+            WriteResult failed;
+            failed.rc = SQLITE_MISUSE;
+            return failed;
+        }
+        queue_.push_back(Pending{std::move(job), std::move(onCommit), {}});
+        result = queue_.back().done.get_future();
+    }
+    wake_.notify_one();
+    return result.get();
+}
+
+bool WriteQueue::startBackup(const std::string &path, std::chrono::milliseconds stepBudget, std::string &error)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_)
+        {
+            error = "writer is not running";
+            return false;
+        }
+        if (backupActive_)
+        {
+            error = "a backup is already running";
+            return false;
+        }
+    }
+
+    auto backup = std::make_shared<OnlineBackup>(path, stepBudget);
+    if (!backup->open(error))
+        return false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (backupActive_)
+        {
+            error = "a backup is already running";
+            return false;
+        }
+        backup_ = std::move(backup);
+        backupActive_ = true;
+    }
+    wake_.notify_one();
+    return true;
+}
+
+BackupProgress WriteQueue::backupProgress() const
+{
+    std::shared_ptr<OnlineBackup> backup;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        backup = backup_;
+    }
+    return backup ? backup->progress() : BackupProgress();
+}
+
+void WriteQueue::loop()
+{
+    std::deque<Pending> batch;
+    for (;;)
+    {
+        std::shared_ptr<OnlineBackup> backup;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            // While a backup runs, wake after its pause even with no writes
+            // queued; a queued write still wakes the thread at once.
+            auto ready = [this] { return !running_ || !queue_.empty(); };
+            if (backupActive_)
+                wake_.wait_for(lock, backup_->pause(), ready);
+            else
+                wake_.wait(lock, [this] { return !running_ || !queue_.empty() || backupActive_; });
+            if (!running_ && queue_.empty())
+            {
+                if (backupActive_)
+                    backup_->cancel();
+                backupActive_ = false;
+                return;
+            }
+            while (!queue_.empty() && batch.size() < maxBatch_)
+            {
+                batch.push_back(std::move(queue_.front()));
+                queue_.pop_front();
+            }
+            if (backupActive_)
+                backup = backup_;
+        }
+        if (!batch.empty())
+        {
+            commitBatch(batch);
+            batch.clear();
+        }
+
+        // One bounded backup step between batches, so a write waits behind
+        // at most one step.
+        if (backup && !backup->step(*conn_))
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            backupActive_ = false;
+        }
+    }
+}
+
+void WriteQueue::commitBatch(std::deque<Pending> &batch)
+{
+    std::vector<WriteResult> results(batch.size());
+    bool began = false;
+    {
+        Stmt begin(*conn_, "BEGIN IMMEDIATE");
+        began = begin && sqlite3_step(begin) == SQLITE_DONE;
+    }
+
+    if (began)
+    {
+        for (size_t i = 0; i < batch.size(); ++i)
+        {
+            {
+                Stmt savepoint(*conn_, "SAVEPOINT job");
+                sqlite3_step(savepoint);
+            }
+            for (WriteListener *listener : listeners_)
+                listener->jobBegan();
+            results[i] = batch[i].job(*conn_);
+            if (!results[i].ok())
+            {
+                Stmt rollback(*conn_, "ROLLBACK TO job");
+                sqlite3_step(rollback);
+                for (WriteListener *listener : listeners_)
+                    listener->jobRolledBack();
+            }
+            Stmt release(*conn_, "RELEASE job");
+            sqlite3_step(release);
+        }
+
+        int rc;
+        {
+            auto started = std::chrono::steady_clock::now();
+            Stmt commit(*conn_, "COMMIT");
+            rc = commit ? sqlite3_step(commit) : SQLITE_ERROR;
+            recordSqlite(SqliteOp::Commit, std::chrono::steady_clock::now() - started);
+        }
+        if (rc != SQLITE_DONE)
+        {
+            std::cerr << "Write batch commit failed: " << sqlite3_errmsg(conn_->handle()) << std::endl;
+            conn_->exec("ROLLBACK");
+            for (auto &result : results)
+                result.rc = rc;
+        }
+        for (WriteListener *listener : listeners_)
+            listener->batchEnded(rc == SQLITE_DONE);
+        if (rc == SQLITE_DONE)
+        {
+            for (size_t i = 0; i < batch.size(); ++i)
+                if (results[i].ok() && batch[i].onCommit)
+                    batch[i].onCommit(results[i]);
+        }
+    }
+    else
+    {
+        std::cerr << "Write batch begin failed: " << sqlite3_errmsg(conn_->handle()) << std::endl;
+        for (auto &result : results)
+            result.rc = SQLITE_BUSY;
+    }
+
+    for (size_t i = 0; i < batch.size(); ++i)
+        batch[i].done.set_value(results[i]);
+}
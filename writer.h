@@ -0,0 +1,104 @@
+#pragma once
+
+#include "backup.h"
+#include "db.h"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Outcome of one queued write, filled in by the writer thread.
+struct WriteResult
+{
+    int rc = SQLITE_OK;
+    sqlite3_int64 rowid = 0;
+    int changes = 0;
+
+    bool ok() const { return rc == SQLITE_OK || rc == SQLITE_DONE; }
+};
+
+// Steps a mutation statement and records its rowid and change count.
+WriteResult stepWrite(DbConnection &conn, sqlite3_stmt *stmt);
+
+// In-memory state that writer jobs change directly, alongside the database,
+// and that has to roll back with it. The writer calls these on its own
+// thread: jobBegan() before each job, jobRolledBack() when the job failed and
+// its savepoint was rolled back, and batchEnded() once the batch's
+// transaction has committed or been rolled back as a whole. writerStarted()
+// hands over the writer's connection once, before the first batch.
+class WriteListener
+{
+public:
+    virtual ~WriteListener() = default;
+    virtual void writerStarted(DbConnection &) {}
+    virtual void jobBegan() = 0;
+    virtual void jobRolledBack() = 0;
+    virtual void batchEnded(bool committed) = 0;
+};
+
+// Funnels every mutation through one thread that owns its own connection.
+// Whatever is queued while the previous batch commits is run as the next
+// batch inside a single transaction, so a burst of inserts pays for one WAL
+// sync instead of one per row. Each job gets its own savepoint, so a failing
+// job rolls back alone without taking the rest of its batch with it.
+class WriteQueue
+{
+public:
+    using Job = std::function<WriteResult(DbConnection &)>;
+    using CommitHook = std::function<void(const WriteResult &)>;
+
+    explicit WriteQueue(DbPool &pool, size_t maxBatch = 256)
+        : pool_(pool), maxBatch_(maxBatch) {}
+    ~WriteQueue() { stop(); }
+
+    WriteQueue(const WriteQueue &) = delete;
+    WriteQueue &operator=(const WriteQueue &) = delete;
+
+    // Registers `listener`; call before start().
+    void addListener(WriteListener &listener) { listeners_.push_back(&listener); }
+
+    bool start();
+    void stop();
+
+    // Queues `job` and blocks until the transaction containing it has
+    // committed. Anything the job binds must stay alive until this returns.
+    // If the job succeeded and the commit went through, `onCommit` runs on the
+    // writer thread, in commit order, before run() returns; in-memory state
+    // that mirrors the database is updated there.
+    WriteResult run(Job job, CommitHook onCommit = nullptr);
+
+    // Starts an online backup to `path`, stepped on the writer thread
+    // between batches (see OnlineBackup). Fails if one is already running.
+    bool startBackup(const std::string &path, std::chrono::milliseconds stepBudget, std::string &error);
+
+    // Progress of the running or most recent backup.
+    BackupProgress backupProgress() const;
+
+private:
+    struct Pending
+    {
+        Job job;
+        CommitHook onCommit;
+        std::promise<WriteResult> done;
+    };
+
+    void loop();
+    void commitBatch(std::deque<Pending> &batch);
+
+    DbPool &pool_;
+    size_t maxBatch_;
+    std::unique_ptr<DbConnection> conn_;
+    std::vector<WriteListener *> listeners_;
+    std::thread thread_;
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::deque<Pending> queue_;
+    std::shared_ptr<OnlineBackup> backup_;  // most recent backup, if any
+    bool backupActive_ = false;
+    bool running_ = false;
+};